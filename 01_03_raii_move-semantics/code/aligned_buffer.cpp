@@ -0,0 +1,124 @@
+#include "aligned_buffer.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _MSC_VER
+    #define NOINLINE __declspec(noinline)
+#else
+    #define NOINLINE __attribute__((noinline))
+#endif
+
+
+// Out of line, so the compiler cannot merge it with the zeroing.
+NOINLINE void overwrite(std::byte* data, size_t size) {
+    std::memset(data, 1, size);
+}
+
+
+// Reads one byte per page, so the buffer is not optimized away.
+size_t checksum(const std::byte* data, size_t size) {
+    size_t sum = 0;
+    for (size_t idx = 0; idx < size; idx += 4096) {
+        sum += size_t(data[idx]);
+    }
+    return sum;
+}
+
+
+// Allocate a buffer, fill it once with our own data, and free it again.
+template <class MakeBuffer>
+double MeasureMicroseconds(size_t size, size_t reps, MakeBuffer&& make_buffer) {
+    using std::chrono::high_resolution_clock;
+
+    const auto start = high_resolution_clock::now();
+    size_t sum = 0;
+    for (size_t rep = 0; rep < reps; ++rep) {
+        auto [data, owner] = make_buffer(size);
+        overwrite(data, size);
+        sum += checksum(data, size);
+    }
+    const auto end = high_resolution_clock::now();
+    if (sum != reps * ((size + 4095) / 4096)) {
+        throw std::logic_error("incorrect result");
+    }
+    return std::chrono::duration<double, std::micro>(end - start).count() / reps;
+}
+
+
+void Usage() {
+    aligned_buffer<64> b(1000);
+    assert(b.valid() && b.size() == 1000);
+    assert(reinterpret_cast<uintptr_t>(b.data()) % 64 == 0);
+
+    // 1000 bytes are 250 floats, or 125 doubles.
+    auto floats = b.as_span<float>();
+    assert(floats.size() == 250);
+    floats[0] = 1.0f;
+
+    aligned_buffer<64> b2 = std::move(b);
+    assert(!b.valid() && b.size() == 0);
+    assert(b2.valid() && b2.as_span<float>()[0] == 1.0f);
+
+    arena scratch(1 << 20);
+    {
+        aligned_buffer<4096, arena_allocator> page(4096, arena_allocator(scratch));
+        aligned_buffer<4096, arena_allocator> next(100, arena_allocator(scratch));
+        assert(next.data() == page.data() + 4096);
+    }
+    scratch.reset();
+    assert(scratch.used() == 0);
+}
+
+
+int main() {
+    Usage();
+
+    constexpr size_t max_size = 256 * 1024 * 1024;
+    arena scratch(max_size + 4096);
+
+    std::cout << std::fixed << std::setprecision(1);
+    for (size_t size = 4096; size <= max_size; size *= 16) {
+        const size_t reps = std::max(size_t(10), 1'000'000'000 / size);
+
+        // Each returns the data and whatever owns it. Huge pages only pay off
+        // for large buffers, the kernel zeroes a whole 2 MiB page on first touch.
+        const auto zeroed = MeasureMicroseconds(size, reps, [](size_t n) {
+            auto p = std::make_unique<std::byte[]>(n);
+            return std::pair{ p.get(), std::move(p) };
+        });
+        const auto for_overwrite = MeasureMicroseconds(size, reps, [](size_t n) {
+            auto p = std::make_unique_for_overwrite<std::byte[]>(n);
+            return std::pair{ p.get(), std::move(p) };
+        });
+        const auto aligned = MeasureMicroseconds(size, reps, [](size_t n) {
+            aligned_buffer<64> b(n);
+            return std::pair{ b.data(), std::move(b) };
+        });
+        const auto huge_pages = MeasureMicroseconds(size, reps, [](size_t n) {
+            aligned_buffer<64, huge_page_allocator> b(n);
+            return std::pair{ b.data(), std::move(b) };
+        });
+        const auto arena = MeasureMicroseconds(size, reps, [&scratch](size_t n) {
+            scratch.reset();
+            aligned_buffer<64, arena_allocator> b(n, arena_allocator(scratch));
+            return std::pair{ b.data(), std::move(b) };
+        });
+
+        std::cout << "size = " << std::setw(10) << size << ":  "
+                  << "zeroed " << zeroed << " us, "
+                  << "for overwrite " << for_overwrite << " us, "
+                  << "aligned_buffer " << aligned << " us, "
+                  << "huge pages " << huge_pages << " us, "
+                  << "arena " << arena << " us" << std::endl;
+    }
+}
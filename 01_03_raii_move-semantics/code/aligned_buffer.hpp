@@ -0,0 +1,187 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+
+#if defined(__linux__)
+    #include <sys/mman.h>
+#endif
+
+
+// The buffer from raii_buffer.cpp, grown up:
+//
+//   aligned_buffer<64> b(n);                      // n bytes at a cache line boundary
+//   std::span<float> floats = b.as_span<float>(); // n / sizeof(float) floats
+//
+// Unlike std::make_unique<char[]>(n), the memory is not zeroed, like with
+// std::make_unique_for_overwrite. Zeroing touches every page of a large
+// buffer, which is wasted if the buffer is overwritten anyway.
+//
+// Where the memory comes from is up to the Allocator, which has
+//
+//   std::byte* allocate(size_t size, size_t alignment);
+//   void deallocate(std::byte* p, size_t size, size_t alignment) noexcept;
+
+
+inline size_t round_up(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+
+// Plain aligned_alloc, or _aligned_malloc on Windows.
+struct malloc_allocator {
+    std::byte* allocate(size_t size, size_t alignment) {
+        // aligned_alloc requires the size to be a multiple of the alignment.
+        const size_t rounded = round_up(size, alignment);
+#if defined(_MSC_VER)
+        void* p = _aligned_malloc(rounded, alignment);
+#else
+        void* p = std::aligned_alloc(alignment, rounded);
+#endif
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return static_cast<std::byte*>(p);
+    }
+
+    void deallocate(std::byte* p, size_t /*size*/, size_t /*alignment*/) noexcept {
+#if defined(_MSC_VER)
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+};
+
+
+// Asks Linux to back the memory with transparent huge pages. A 2 MiB page
+// needs one TLB entry instead of 512 for 4 KiB pages. Elsewhere, or if the
+// kernel does not want to, these are ordinary pages.
+struct huge_page_allocator {
+    static constexpr size_t huge_page_size = 2 * 1024 * 1024;
+
+    std::byte* allocate(size_t size, size_t alignment) {
+        std::byte* p = malloc_allocator{}.allocate(size, std::max(alignment, huge_page_size));
+#if defined(__linux__)
+        // Only a hint, the memory is usable either way.
+        madvise(p, round_up(size, huge_page_size), MADV_HUGEPAGE);
+#endif
+        return p;
+    }
+
+    void deallocate(std::byte* p, size_t size, size_t alignment) noexcept {
+        malloc_allocator{}.deallocate(p, size, alignment);
+    }
+};
+
+
+// Hands out consecutive pieces of one block, and frees them all at once on
+// reset, so allocating is little more than incrementing an offset. The
+// block is allocated up front and reused, so its pages are only faulted in
+// the first time around.
+class arena {
+public:
+    explicit arena(size_t capacity) : m_memory(new std::byte[capacity]), m_capacity(capacity) {}
+
+    std::byte* allocate(size_t size, size_t alignment) {
+        assert(std::has_single_bit(alignment));
+        const auto base = reinterpret_cast<uintptr_t>(m_memory.get());
+        const auto first = (base + m_used + alignment - 1) & ~uintptr_t(alignment - 1);
+        const size_t offset = first - base;
+        if (offset + size > m_capacity) {
+            throw std::bad_alloc();
+        }
+        m_used = offset + size;
+        return m_memory.get() + offset;
+    }
+
+    // All memory handed out so far must not be used anymore.
+    void reset() noexcept { m_used = 0; }
+
+    size_t used() const noexcept { return m_used; }
+    size_t capacity() const noexcept { return m_capacity; }
+
+private:
+    std::unique_ptr<std::byte[]> m_memory;
+    size_t m_capacity;
+    size_t m_used = 0;
+};
+
+
+// Allocator for an arena that the caller keeps alive. Deallocating does
+// nothing, the memory is reclaimed by arena::reset.
+class arena_allocator {
+public:
+    explicit arena_allocator(arena& arena) : m_arena(&arena) {}
+
+    std::byte* allocate(size_t size, size_t alignment) { return m_arena->allocate(size, alignment); }
+    void deallocate(std::byte*, size_t, size_t) noexcept {}
+
+private:
+    arena* m_arena;
+};
+
+
+template <size_t Alignment = alignof(std::max_align_t), class Allocator = malloc_allocator>
+class aligned_buffer {
+    static_assert(std::has_single_bit(Alignment), "alignment must be a power of two");
+
+    // The size lives in the deleter, which needs it to deallocate anyway.
+    struct deleter {
+        Allocator allocator;
+        size_t size = 0;
+
+        void operator()(std::byte* p) noexcept { allocator.deallocate(p, size, Alignment); }
+    };
+
+public:
+    static constexpr size_t alignment = Alignment;
+
+    // Default construction results in an empty buffer
+    aligned_buffer() = default;
+
+    // Construct a buffer of size uninitialized bytes
+    explicit aligned_buffer(size_t size, Allocator allocator = Allocator{})
+        : m_data(size > 0 ? allocator.allocate(size, Alignment) : nullptr, deleter{ allocator, size }) {}
+
+    // Moves empty the source buffer, copies are not possible, as for buffer
+    aligned_buffer(aligned_buffer&&) noexcept = default;
+    aligned_buffer& operator=(aligned_buffer&&) noexcept = default;
+    aligned_buffer(const aligned_buffer&) = delete;
+    aligned_buffer& operator=(const aligned_buffer&) = delete;
+    ~aligned_buffer() = default;
+
+    bool valid() const noexcept { return bool(m_data); }
+    size_t size() const noexcept { return m_data ? m_data.get_deleter().size : 0; }
+
+    std::byte* data() noexcept { return m_data.get(); }
+    const std::byte* data() const noexcept { return m_data.get(); }
+
+    // View of the buffer as whole elements of T. Only for types that can live
+    // in raw memory without running a constructor, like numbers and plain
+    // structs of numbers; the elements are as uninitialized as the bytes.
+    template <class T>
+    std::span<T> as_span() noexcept {
+        static_assert(std::is_trivially_copyable_v<T>, "T must not need construction");
+        static_assert(alignof(T) <= Alignment, "T needs a larger alignment than the buffer has");
+        return { reinterpret_cast<T*>(data()), size() / sizeof(T) };
+    }
+
+    template <class T>
+    std::span<const T> as_span() const noexcept {
+        static_assert(std::is_trivially_copyable_v<T>, "T must not need construction");
+        static_assert(alignof(T) <= Alignment, "T needs a larger alignment than the buffer has");
+        return { reinterpret_cast<const T*>(data()), size() / sizeof(T) };
+    }
+
+private:
+    std::unique_ptr<std::byte, deleter> m_data;
+};
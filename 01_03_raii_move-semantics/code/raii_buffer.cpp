@@ -5,6 +5,8 @@
 // Abstraction around a generic memory buffer. As always, be careful managing
 // buffers like these, but if you're going to use them at least ensure that
 // resources are freed correctly by using RAII and rule of zero/five!
+// See aligned_buffer.hpp for a version with alignment, uninitialized memory
+// and custom allocators.
 class buffer {
     using buffer_type = char[];
 
@@ -20,6 +22,9 @@ public:
         // 3.
         // new char[n]()
         //
+        // 4.
+        // std::make_unique_for_overwrite<buffer_type>(n)
+        //
         // See overload 2) of
         // https://en.cppreference.com/w/cpp/memory/unique_ptr/make_unique and
         // 2.2 of https://en.cppreference.com/w/cpp/language/new.
@@ -39,10 +44,11 @@ public:
     // Move assignment empties the source buffer
     buffer& operator=(buffer&&) = default;
 
-    // Copy construction is disabled thanks to unique_ptr having a deleted copy constructor
-    buffer(buffer const&) = default;
-    // Copy assignment is deleted thanks to unique_ptr having a deleted copy assignment operator
-    buffer& operator=(buffer const&) = default;
+    // Copy construction is disabled, unique_ptr has a deleted copy constructor
+    // anyway, so defaulting it would silently define it as deleted as well
+    buffer(buffer const&) = delete;
+    // Copy assignment is disabled, for the same reason
+    buffer& operator=(buffer const&) = delete;
 
     // Destructor will release the buffer, if p contains one
     ~buffer() = default;
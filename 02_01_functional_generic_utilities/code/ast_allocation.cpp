@@ -0,0 +1,59 @@
+#include "ast_pmr.hpp"
+#include "memory_resources.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+
+
+// Build, evaluate and destroy the tree reps times, with the nodes from resource.
+template <class AfterRep>
+double MeasureMilliseconds(size_t size, size_t reps, std::pmr::memory_resource* resource, AfterRep&& after_rep) {
+    using std::chrono::high_resolution_clock;
+
+    const int expected = eval(make_tree(size, std::pmr::new_delete_resource()));
+    const auto start = high_resolution_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        {
+            const ast tree = make_tree(size, resource);
+            if (eval(tree) != expected) {
+                throw std::logic_error("incorrect result");
+            }
+        }
+        after_rep();
+    }
+    const auto end = high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / reps;
+}
+
+
+int main() {
+    constexpr size_t size = 1'000'000;
+    constexpr size_t reps = 10;
+
+    const auto report = [](const std::string& name, double time, const counting_resource& heap) {
+        std::cout << name << ": " << time << " ms, "
+                  << heap.allocations() << " heap allocations for " << reps << " trees" << std::endl;
+    };
+
+    {
+        counting_resource heap;
+        const auto time = MeasureMilliseconds(size, reps, &heap, [] {});
+        report("new/delete", time, heap);
+    }
+    {
+        counting_resource heap;
+        size_class_pool pool(&heap);
+        const auto time = MeasureMilliseconds(size, reps, &pool, [] {});
+        report("size class pool", time, heap);
+    }
+    {
+        counting_resource heap;
+        frame_arena frame(64 * 1024, &heap);
+        const auto time = MeasureMilliseconds(size, reps, &frame, [&frame] { frame.reset(); });
+        report("frame arena", time, heap);
+    }
+}
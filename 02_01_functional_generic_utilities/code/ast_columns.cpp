@@ -0,0 +1,158 @@
+#include "ast_columns.hpp"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// The particles of Particle::evalForce in examples/struct_layout.cpp of
+// 03_01_data_oriented_design, as columns. The branches on fixed_* and kind
+// become columns of 0 and 1 that the terms are multiplied with.
+enum Column {
+    charge,
+    mass,
+    pos_z,
+    v_x,
+    v_y,
+    v_z,
+    free_x,   // 0 if fixed_x.
+    free_y,
+    free_z,
+    with_drag, // 1 if kind == PKind::WithDrag.
+    floating,  // 1 if kind == PKind::Floating.
+    num_columns
+};
+
+struct Particles {
+    explicit Particles(size_t size) {
+        std::mt19937 gen(9823);
+        std::uniform_int_distribution<int> kindG(0, 2);
+        std::uniform_real_distribution<double> unitBox(-1.0, 1.0);
+        std::uniform_real_distribution<double> massG(1.0, 6.0);
+        std::uniform_int_distribution<int> boolG(0, 9);
+        std::uniform_int_distribution<int> chargeG(-1, 1);
+        std::normal_distribution<double> vG{ 0.0, 1.0 };
+        for (auto& c : columns) {
+            c.resize(size);
+        }
+        for (size_t idx = 0; idx < size; ++idx) {
+            const int kind = kindG(gen);
+            columns[charge][idx] = chargeG(gen);
+            columns[mass][idx] = massG(gen);
+            columns[pos_z][idx] = unitBox(gen);
+            columns[v_x][idx] = vG(gen);
+            columns[v_y][idx] = vG(gen);
+            columns[v_z][idx] = vG(gen);
+            columns[free_x][idx] = boolG(gen) != 0;
+            columns[free_y][idx] = boolG(gen) != 0;
+            columns[free_z][idx] = boolG(gen) != 0;
+            columns[with_drag][idx] = kind == 2;
+            columns[floating][idx] = kind == 1;
+        }
+        for (size_t idx = 0; idx < num_columns; ++idx) {
+            views[idx] = columns[idx];
+        }
+    }
+
+    std::array<std::vector<double>, num_columns> columns;
+    std::array<std::span<const double>, num_columns> views;
+};
+
+// evalForce with epsilon 0.01 and field (1, 1, 1), as in System::advance.
+std::array<column_expr, 3> ForceExpressions() {
+    const auto c = [](Column idx) { return column(idx); };
+    const auto epsilon = constant(0.01);
+    const auto field_x = constant(1.0);
+    const auto field_y = constant(1.0);
+    const auto field_z = constant(1.0);
+    const auto drag = constant(-0.1);
+    const auto floatiness = constant(-0.004);
+    return {
+        c(free_x) * (c(charge) * epsilon * (c(v_y) * field_z - c(v_z) * field_y) + drag * c(with_drag) * c(mass) * c(v_x)),
+        c(free_y) * (c(charge) * epsilon * (c(v_z) * field_x - c(v_x) * field_z) + drag * c(with_drag) * c(mass) * c(v_y)),
+        c(free_z) * (c(charge) * epsilon * (c(v_x) * field_y - c(v_y) * field_x) + drag * c(with_drag) * c(mass) * c(v_z))
+            + floatiness * c(floating) * c(pos_z),
+    };
+}
+
+// The same, written out by hand, which is what the expressions should get
+// close to.
+void HandWritten(const Particles& p, std::span<double> f_x, std::span<double> f_y, std::span<double> f_z) {
+    const auto& c = p.columns;
+    for (size_t idx = 0; idx < f_x.size(); ++idx) {
+        const double q = c[charge][idx] * 0.01;
+        const double drag = -0.1 * c[with_drag][idx] * c[mass][idx];
+        f_x[idx] = c[free_x][idx] * (q * (c[v_y][idx] - c[v_z][idx]) + drag * c[v_x][idx]);
+        f_y[idx] = c[free_y][idx] * (q * (c[v_z][idx] - c[v_x][idx]) + drag * c[v_y][idx]);
+        f_z[idx] = c[free_z][idx] * (q * (c[v_x][idx] - c[v_y][idx]) + drag * c[v_z][idx])
+                   - 0.004 * c[floating][idx] * c[pos_z][idx];
+    }
+}
+
+template <class Fun>
+double MeasureMilliseconds(size_t reps, Fun&& fun) {
+    using std::chrono::high_resolution_clock;
+
+    const auto start = high_resolution_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        fun();
+    }
+    const auto end = high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / reps;
+}
+
+void Check(std::span<const double> result, std::span<const double> expected) {
+    for (size_t idx = 0; idx < result.size(); ++idx) {
+        if (std::abs(result[idx] - expected[idx]) > 1e-12) {
+            throw std::logic_error("incorrect result");
+        }
+    }
+}
+
+int main() {
+    constexpr size_t size = 1 << 20;
+    constexpr size_t reps = 10;
+
+    const Particles particles(size);
+    const auto forces = ForceExpressions();
+    std::array<std::vector<double>, 3> expected;
+    std::array<std::vector<double>, 3> result;
+    for (size_t dim = 0; dim < 3; ++dim) {
+        expected[dim].resize(size);
+        result[dim].resize(size);
+    }
+
+    const auto hand_time = MeasureMilliseconds(reps, [&] { HandWritten(particles, expected[0], expected[1], expected[2]); });
+    std::cout << size << " particles, " << forces[2].size() << " nodes for f_z\n"
+              << "hand written:  " << hand_time << " ms" << std::endl;
+
+    const auto rows_time = MeasureMilliseconds(reps, [&] {
+        for (size_t dim = 0; dim < 3; ++dim) {
+            eval_rows(forces[dim], particles.views, result[dim]);
+        }
+    });
+    for (size_t dim = 0; dim < 3; ++dim) {
+        Check(result[dim], expected[dim]);
+    }
+    std::cout << "row by row:    " << rows_time << " ms" << std::endl;
+
+    // Too small chunks pay the interpretation per node often, too large ones
+    // spill the intermediate columns out of the cache.
+    for (size_t chunk = 16; chunk <= size; chunk *= 4) {
+        const auto columns_time = MeasureMilliseconds(reps, [&] {
+            for (size_t dim = 0; dim < 3; ++dim) {
+                eval_columns(forces[dim], particles.views, result[dim], chunk);
+            }
+        });
+        for (size_t dim = 0; dim < 3; ++dim) {
+            Check(result[dim], expected[dim]);
+        }
+        std::cout << "chunks of " << chunk << ": " << columns_time << " ms, "
+                  << rows_time / columns_time << "x faster than row by row" << std::endl;
+    }
+}
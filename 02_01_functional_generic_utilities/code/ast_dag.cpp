@@ -0,0 +1,81 @@
+#include "ast_dag.hpp"
+#include "ast_pmr.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+// Like make_tree, but the leaves are random numbers from 0 to 2, so fewer
+// subtrees are identical.
+ast make_random_tree(size_t size, std::mt19937& rne, bool multiply = false) {
+    if (size <= 2) {
+        return lit{ std::uniform_int_distribution<int>(0, 2)(rne) };
+    }
+    if (multiply) {
+        return mkop<mul>(make_random_tree(size - 2, rne, false), lit{ 1 });
+    }
+    const size_t left = (size - 1) / 2;
+    auto lhs = make_random_tree(left, rne, true);
+    auto rhs = make_random_tree(size - 1 - left, rne, true);
+    return mkop<add>(std::move(lhs), std::move(rhs));
+}
+
+template <class Fun>
+double MeasureMilliseconds(size_t reps, Fun&& fun) {
+    using std::chrono::high_resolution_clock;
+
+    const auto start = high_resolution_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        fun();
+    }
+    const auto end = high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / reps;
+}
+
+// Evaluates the expression reps times as a tree, and as a dag with and
+// without constant folding. The dag is built once, and every evaluation
+// computes all of its nodes from scratch, since a second eval() would only
+// read back the cached root. Building pays off once the evaluations it saves
+// took longer than the build.
+void Compare(const std::string& name, ast const& tree, size_t reps) {
+    const int expected = eval(tree);
+    const auto check = [expected](int result) {
+        if (result != expected) {
+            throw std::logic_error("incorrect result");
+        }
+    };
+
+    const auto tree_time = MeasureMilliseconds(reps, [&] { check(eval(tree)); });
+    std::cout << name << ":\n"
+              << "  tree:                " << tree_time << " ms per evaluation\n";
+
+    for (bool fold_constants : { false, true }) {
+        const auto build_start = std::chrono::high_resolution_clock::now();
+        const dag d(tree, fold_constants);
+        const auto build_end = std::chrono::high_resolution_clock::now();
+        const double build_time = std::chrono::duration<double, std::milli>(build_end - build_start).count();
+
+        check(d.eval());
+        const auto scratch_time = MeasureMilliseconds(reps, [&] { check(d.evaluate()[d.root()]); });
+        const std::string pays_off = scratch_time < tree_time
+                                         ? "after " + std::to_string(int(build_time / (tree_time - scratch_time)) + 1) + " evaluations"
+                                         : "never";
+        std::cout << "  " << (fold_constants ? "dag, folded:         " : "dag:                 ")
+                  << d.size() << " nodes, built in " << build_time << " ms, "
+                  << scratch_time << " ms per evaluation, "
+                  << "pays off " << pays_off << "\n";
+    }
+}
+
+int main() {
+    constexpr size_t size = 1'000'000;
+    constexpr size_t reps = 20;
+
+    std::mt19937 rne(2341);
+    Compare("make_tree", make_tree(size), reps);
+    Compare("random leaves", make_random_tree(size, rne), reps);
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "ast_pmr.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// The ast as a DAG: identical subtrees are stored only once (hash-consing),
+// and operations on two literals can be replaced by their result (constant
+// folding). Nodes refer to their children by index, and children always come
+// before their parents, so evaluating the nodes in order evaluates every
+// shared subtree only once.
+
+struct dag_node {
+    enum class kind : uint8_t { lit, add, mul };
+
+    kind k;
+    int value;    // For lit.
+    uint32_t lhs; // For add and mul.
+    uint32_t rhs;
+
+    bool operator==(dag_node const&) const = default;
+};
+
+struct dag_node_hash {
+    size_t operator()(dag_node const& n) const {
+        size_t h = std::hash<int>{}(int(n.k));
+        for (size_t part : { size_t(n.value), size_t(n.lhs), size_t(n.rhs) }) {
+            h ^= part + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+
+class dag {
+public:
+    explicit dag(ast const& a, bool fold_constants = true) : m_fold_constants(fold_constants) {
+        m_root = insert(a);
+        // Only needed while building.
+        m_index = {};
+        remove_unreachable();
+    }
+
+    size_t size() const { return m_nodes.size(); }
+    std::span<const dag_node> nodes() const { return m_nodes; }
+    uint32_t root() const { return m_root; }
+
+    // The values of all nodes, computed from scratch.
+    std::vector<int> evaluate() const {
+        std::vector<int> values(m_nodes.size());
+        for (size_t idx = 0; idx < m_nodes.size(); ++idx) {
+            const auto& n = m_nodes[idx];
+            switch (n.k) {
+                case dag_node::kind::lit: values[idx] = n.value; break;
+                case dag_node::kind::add: values[idx] = values[n.lhs] + values[n.rhs]; break;
+                case dag_node::kind::mul: values[idx] = values[n.lhs] * values[n.rhs]; break;
+            }
+        }
+        return values;
+    }
+
+    // The value of a node, evaluated on first use and cached, so evaluating
+    // the same dag again, or any of its subexpressions, is a lookup.
+    // Not thread-safe.
+    int eval(uint32_t node) const {
+        if (!m_values) {
+            m_values = evaluate();
+        }
+        return (*m_values)[node];
+    }
+
+    int eval() const { return eval(m_root); }
+
+private:
+    uint32_t insert(ast const& a) {
+        return std::visit(
+            overloaded(
+                [&](lit const& l) { return intern({ dag_node::kind::lit, l.x, 0, 0 }); },
+                [&](up<add> const& a) { return insert_op(dag_node::kind::add, a->x, a->y); },
+                [&](up<mul> const& m) { return insert_op(dag_node::kind::mul, m->x, m->y); }),
+            a);
+    }
+
+    uint32_t insert_op(dag_node::kind k, ast const& x, ast const& y) {
+        const uint32_t lhs = insert(x);
+        const uint32_t rhs = insert(y);
+        const auto& l = m_nodes[lhs];
+        const auto& r = m_nodes[rhs];
+        if (m_fold_constants && l.k == dag_node::kind::lit && r.k == dag_node::kind::lit) {
+            const int value = k == dag_node::kind::add ? l.value + r.value : l.value * r.value;
+            return intern({ dag_node::kind::lit, value, 0, 0 });
+        }
+        return intern({ k, 0, lhs, rhs });
+    }
+
+    uint32_t intern(dag_node const& node) {
+        const auto [it, inserted] = m_index.try_emplace(node, uint32_t(m_nodes.size()));
+        if (inserted) {
+            m_nodes.push_back(node);
+        }
+        return it->second;
+    }
+
+    // Folding leaves behind the operands it folded. Children come before
+    // their parents, so one pass from the root down finds the reachable
+    // nodes, and one pass up moves them together.
+    void remove_unreachable() {
+        std::vector<bool> reachable(m_nodes.size());
+        reachable[m_root] = true;
+        for (size_t idx = m_nodes.size(); idx-- > 0;) {
+            if (reachable[idx] && m_nodes[idx].k != dag_node::kind::lit) {
+                reachable[m_nodes[idx].lhs] = true;
+                reachable[m_nodes[idx].rhs] = true;
+            }
+        }
+
+        std::vector<uint32_t> new_idx(m_nodes.size());
+        size_t count = 0;
+        for (size_t idx = 0; idx < m_nodes.size(); ++idx) {
+            if (reachable[idx]) {
+                auto node = m_nodes[idx];
+                if (node.k != dag_node::kind::lit) {
+                    node.lhs = new_idx[node.lhs];
+                    node.rhs = new_idx[node.rhs];
+                }
+                new_idx[idx] = uint32_t(count);
+                m_nodes[count++] = node;
+            }
+        }
+        m_nodes.resize(count);
+        m_root = new_idx[m_root];
+    }
+
+    bool m_fold_constants;
+    std::vector<dag_node> m_nodes;
+    std::unordered_map<dag_node, uint32_t, dag_node_hash> m_index;
+    uint32_t m_root;
+    mutable std::optional<std::vector<int>> m_values;
+};
@@ -0,0 +1,74 @@
+#include "ast_flat.hpp"
+#include "ast_pmr.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+template <class Eval>
+double MeasureMilliseconds(size_t reps, int expected, Eval&& eval) {
+    using std::chrono::high_resolution_clock;
+
+    const auto start = high_resolution_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        if (eval() != expected) {
+            throw std::logic_error("incorrect result");
+        }
+    }
+    const auto end = high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / reps;
+}
+
+int main() {
+    constexpr size_t size = 1'000'000;
+    constexpr size_t reps = 20;
+
+    // One big expression, evaluated as a tree and flattened.
+    const ast tree = make_tree(size);
+    const flat_ast flat = flatten(tree);
+    const int expected = eval(tree);
+
+    const auto tree_time = MeasureMilliseconds(reps, expected, [&] { return eval(tree); });
+    const auto flat_time = MeasureMilliseconds(reps, expected, [&] { return eval(flat); });
+    std::cout << flat.size() << " nodes: "
+              << "pointer tree " << tree_time << " ms, "
+              << "flat " << flat_time << " ms, "
+              << "speedup " << tree_time / flat_time << "x" << std::endl;
+
+    // The same expression with a variable as every leaf, set to 1.
+    if (eval(make_flat_tree(size, 1), std::vector{ 1 }) != expected) {
+        throw std::logic_error("incorrect result");
+    }
+
+    // A smaller formula for many bindings of its variables.
+    constexpr size_t formula_size = 1000;
+    constexpr size_t num_vars = 8;
+    constexpr size_t num_bindings = 100'000;
+
+    const flat_ast formula = make_flat_tree(formula_size, num_vars);
+    std::mt19937 rne(4563);
+    std::uniform_int_distribution<int> value_rng(0, 3);
+    std::vector<int> bindings(num_bindings * num_vars);
+    for (auto& value : bindings) {
+        value = value_rng(rne);
+    }
+    std::vector<int> results(num_bindings);
+
+    const auto start = std::chrono::high_resolution_clock::now();
+    eval_batch(formula, bindings, results);
+    const auto end = std::chrono::high_resolution_clock::now();
+
+    for (size_t idx = 0; idx < num_bindings; idx += 997) {
+        if (results[idx] != eval(formula, std::span(bindings).subspan(idx * num_vars, num_vars))) {
+            throw std::logic_error("incorrect result");
+        }
+    }
+    const double batch_ns = std::chrono::duration<double, std::nano>(end - start).count();
+    std::cout << formula.size() << " nodes, " << num_bindings << " bindings: "
+              << batch_ns / 1e6 << " ms, "
+              << batch_ns / (num_bindings * formula.size()) << " ns per node" << std::endl;
+}
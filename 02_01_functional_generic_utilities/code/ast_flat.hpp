@@ -0,0 +1,169 @@
+#pragma once
+
+#include "ast_pmr.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+// The ast flattened into postfix order, children before their parent. The
+// nodes live in two parallel arrays (SoA), the operations and their
+// arguments, and refer to their children by position instead of pointers.
+// Evaluating is a single loop that pushes leaves to a stack and replaces the
+// top two values with their sum or product, instead of a recursion through
+// std::visit and pointers to nodes all over the heap.
+//
+// Leaves can also be variables, which are looked up in the values passed to
+// eval, so one flat_ast can be evaluated for many bindings.
+
+enum class op : uint8_t {
+    lit,  // Push the argument.
+    var,  // Push the value of variable number argument.
+    add,
+    mul,
+};
+
+class flat_ast {
+public:
+    void push_lit(int x) { push(op::lit, x); }
+    void push_var(int idx) {
+        push(op::var, idx);
+        m_num_vars = std::max(m_num_vars, size_t(idx) + 1);
+    }
+    void push_add() { push(op::add, 0); }
+    void push_mul() { push(op::mul, 0); }
+
+    size_t size() const { return m_ops.size(); }
+    std::span<const op> ops() const { return m_ops; }
+    std::span<const int> args() const { return m_args; }
+
+    // A complete expression leaves exactly one value on the stack.
+    bool complete() const { return m_depth == 1; }
+    size_t max_depth() const { return m_max_depth; }
+    size_t num_vars() const { return m_num_vars; }
+
+private:
+    void push(op o, int arg) {
+        if (o == op::add || o == op::mul) {
+            if (m_depth < 2) {
+                throw std::logic_error("operation needs two operands");
+            }
+            --m_depth;
+        }
+        else {
+            m_max_depth = std::max(m_max_depth, ++m_depth);
+        }
+        m_ops.push_back(o);
+        m_args.push_back(arg);
+    }
+
+    std::vector<op> m_ops;
+    std::vector<int> m_args;
+    size_t m_depth = 0;
+    size_t m_max_depth = 0;
+    size_t m_num_vars = 0;
+};
+
+inline void flatten_into(flat_ast& out, ast const& a) {
+    std::visit(
+        overloaded(
+            [&](lit const& l) { out.push_lit(l.x); },
+            [&](up<add> const& a) {
+                flatten_into(out, a->x);
+                flatten_into(out, a->y);
+                out.push_add();
+            },
+            [&](up<mul> const& m) {
+                flatten_into(out, m->x);
+                flatten_into(out, m->y);
+                out.push_mul();
+            }),
+        a);
+}
+
+inline flat_ast flatten(ast const& a) {
+    flat_ast out;
+    flatten_into(out, a);
+    return out;
+}
+
+// Requires a complete expression, values for all its variables, and a stack
+// of at least max_depth() elements, which can be reused between calls.
+inline int eval(flat_ast const& e, std::span<const int> vars, std::span<int> stack) {
+    const auto ops = e.ops();
+    const auto args = e.args();
+    int* top = stack.data(); // One past the top value.
+    for (size_t idx = 0; idx < ops.size(); ++idx) {
+        switch (ops[idx]) {
+            case op::lit: *top++ = args[idx]; break;
+            case op::var: *top++ = vars[args[idx]]; break;
+            case op::add:
+                --top;
+                top[-1] += top[0];
+                break;
+            case op::mul:
+                --top;
+                top[-1] *= top[0];
+                break;
+        }
+    }
+    return stack[0];
+}
+
+inline void check_evaluable(flat_ast const& e, size_t num_values) {
+    if (!e.complete()) {
+        throw std::logic_error("incomplete expression");
+    }
+    if (num_values < e.num_vars()) {
+        throw std::invalid_argument("missing variable values");
+    }
+}
+
+inline int eval(flat_ast const& e, std::span<const int> vars = {}) {
+    check_evaluable(e, vars.size());
+    std::vector<int> stack(e.max_depth());
+    return eval(e, vars, stack);
+}
+
+// Evaluates e for every binding, where binding i is the num_vars() values
+// starting at bindings[i * num_vars()], and stores the result in results[i].
+inline void eval_batch(flat_ast const& e, std::span<const int> bindings, std::span<int> results) {
+    const size_t num_vars = e.num_vars();
+    check_evaluable(e, num_vars);
+    if (bindings.size() != results.size() * num_vars) {
+        throw std::invalid_argument("bindings and results do not match");
+    }
+    std::vector<int> stack(e.max_depth());
+    for (size_t idx = 0; idx < results.size(); ++idx) {
+        results[idx] = eval(e, bindings.subspan(idx * num_vars, num_vars), stack);
+    }
+}
+
+// Like make_tree, but with variable leaves, from 0 to num_vars - 1 from left
+// to right and then starting over.
+inline void make_flat_tree_into(flat_ast& out, size_t size, size_t num_vars, size_t& leaf_idx, bool multiply = false) {
+    if (size <= 2) {
+        out.push_var(int(leaf_idx++ % num_vars));
+    }
+    else if (multiply) {
+        make_flat_tree_into(out, size - 2, num_vars, leaf_idx, false);
+        out.push_lit(1);
+        out.push_mul();
+    }
+    else {
+        const size_t left = (size - 1) / 2;
+        make_flat_tree_into(out, left, num_vars, leaf_idx, true);
+        make_flat_tree_into(out, size - 1 - left, num_vars, leaf_idx, true);
+        out.push_add();
+    }
+}
+
+inline flat_ast make_flat_tree(size_t size, size_t num_vars) {
+    flat_ast out;
+    size_t leaf_idx = 0;
+    make_flat_tree_into(out, size, num_vars, leaf_idx);
+    return out;
+}
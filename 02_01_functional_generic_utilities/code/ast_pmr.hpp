@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <variant>
+
+// The ast of ast.cpp, with the nodes allocated from a memory resource, for
+// the allocation, flat and DAG variants.
+
+template <class... Ts>
+struct overloaded : Ts... {
+    using Ts::operator()...;
+};
+
+template <class... Ts>
+overloaded(Ts...) -> overloaded<Ts...>;
+
+struct lit {
+    int x;
+};
+struct add;
+struct mul;
+
+// Nodes come from a memory resource, and go back to the one they came from.
+template <typename T>
+struct node_deleter {
+    std::pmr::memory_resource* resource;
+
+    void operator()(T* p) const { std::pmr::polymorphic_allocator<>(resource).delete_object(p); }
+};
+
+template <typename T>
+using up = std::unique_ptr<T, node_deleter<T>>;
+
+template <typename T, typename U1, typename U2>
+auto mkop(U1&& u1, U2&& u2, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    std::pmr::polymorphic_allocator<> allocator(resource);
+    return up<T>(allocator.new_object<T>(std::forward<U1>(u1), std::forward<U2>(u2)), node_deleter<T>{ resource });
+}
+
+using ast = std::variant<lit, up<add>, up<mul>>;
+
+struct add {
+    ast x, y;
+};
+struct mul {
+    ast x, y;
+};
+
+inline int eval(ast const& a) {
+    return std::visit(
+        overloaded(
+            [](lit const& l) { return l.x; },
+            [](up<add> const& a) { return eval(a->x) + eval(a->y); },
+            [](up<mul> const& m) { return eval(m->x) * eval(m->y); }),
+        a);
+}
+
+// A tree of about size nodes for benchmarks. Levels of add alternate with
+// levels of mul by 1, so the result is the number of leaves and cannot overflow.
+inline ast make_tree(size_t size, std::pmr::memory_resource* resource = std::pmr::get_default_resource(), bool multiply = false) {
+    if (size <= 2) {
+        return lit{ 1 };
+    }
+    if (multiply) {
+        return mkop<mul>(make_tree(size - 2, resource, false), lit{ 1 }, resource);
+    }
+    const size_t left = (size - 1) / 2;
+    return mkop<add>(make_tree(left, resource, true), make_tree(size - 1 - left, resource, true), resource);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations in num_allocations, by replacing the global
+// operator new and delete. Include it in one translation unit per program.
+std::atomic<size_t> num_allocations = 0;
+
+void* operator new(size_t size) {
+    ++num_allocations;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
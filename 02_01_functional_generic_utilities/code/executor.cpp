@@ -0,0 +1,101 @@
+#include "count_allocations.hpp"
+#include "executor.hpp"
+#include "make_task.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+void fill(int* array, int n, int x) {
+    for (int i = 0; i < n; ++i) {
+        array[i] = x;
+    }
+}
+
+// Runs num_tasks small tasks with launch, which gets the task number and the
+// task, and reports tasks per second and heap allocations per task.
+template <class Launch>
+void Measure(const std::string& name, size_t num_tasks, Launch&& launch) {
+    constexpr int n = 16;
+    std::vector<int> v(num_tasks * n);
+
+    const size_t allocations_before = num_allocations;
+    const auto start = std::chrono::high_resolution_clock::now();
+    launch(num_tasks, [&](size_t idx) { return make_task(fill, v.data() + idx * n, n, int(idx)); });
+    const auto end = std::chrono::high_resolution_clock::now();
+    const size_t allocations = num_allocations - allocations_before;
+
+    for (size_t idx = 0; idx < num_tasks; ++idx) {
+        if (v[idx * n] != int(idx) || v[idx * n + n - 1] != int(idx)) {
+            throw std::logic_error("incorrect result");
+        }
+    }
+    const double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << name << num_tasks / seconds << " tasks/s, "
+              << double(allocations) / num_tasks << " allocations per task" << std::endl;
+}
+
+int main() {
+    constexpr size_t num_tasks = 100'000;
+    // Threads are started in batches, so that not all of them exist at once.
+    constexpr size_t batch = 64;
+
+    static_assert(small_task::fits_inline<decltype(make_task(fill, (int*)nullptr, 0, 0))>);
+
+    Measure("std::thread:        ", num_tasks / 10, [](size_t num_tasks, auto make) {
+        std::vector<std::thread> threads;
+        for (size_t first = 0; first < num_tasks; first += batch) {
+            for (size_t idx = first; idx < std::min(num_tasks, first + batch); ++idx) {
+                threads.emplace_back(make(idx));
+            }
+            for (auto& th : threads) {
+                th.join();
+            }
+            threads.clear();
+        }
+    });
+
+    Measure("std::async:         ", num_tasks / 10, [](size_t num_tasks, auto make) {
+        std::vector<std::future<void>> futures;
+        for (size_t first = 0; first < num_tasks; first += batch) {
+            for (size_t idx = first; idx < std::min(num_tasks, first + batch); ++idx) {
+                futures.push_back(std::async(std::launch::async, make(idx)));
+            }
+            for (auto& f : futures) {
+                f.get();
+            }
+            futures.clear();
+        }
+    });
+
+    executor pool;
+    // Let the queue grow once, so that the measurements see its steady state.
+    for (size_t idx = 0; idx < num_tasks; ++idx) {
+        pool.post([] {});
+    }
+    pool.wait();
+
+    Measure("executor, post:     ", num_tasks, [&pool](size_t num_tasks, auto make) {
+        for (size_t idx = 0; idx < num_tasks; ++idx) {
+            pool.post(make(idx));
+        }
+        pool.wait();
+    });
+
+    Measure("executor, submit:   ", num_tasks, [&pool](size_t num_tasks, auto make) {
+        std::vector<std::future<void>> futures;
+        futures.reserve(num_tasks);
+        for (size_t idx = 0; idx < num_tasks; ++idx) {
+            futures.push_back(pool.submit(make(idx)));
+        }
+        for (auto& f : futures) {
+            f.get();
+        }
+    });
+}
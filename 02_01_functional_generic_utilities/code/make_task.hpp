@@ -0,0 +1,28 @@
+#pragma once
+
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// A function together with the arguments to call it with, stored by value.
+template <typename F, typename... Ts>
+struct task {
+    std::decay_t<F> f;
+    std::tuple<std::decay_t<Ts>...> t;
+
+    void operator()() {
+        std::apply([&](auto&... ts) {
+            f(ts...);
+        }, t);
+        // or if there are no additional arguments to pass to f simply:
+        // std::apply(f, t);
+    }
+};
+
+template <typename F, typename... Ts>
+auto make_task(F&& f, Ts&&... ts) {
+    return task<F, Ts...>{
+        std::forward<F>(f),
+        std::tuple<std::decay_t<Ts>...>(std::forward<Ts>(ts)...)
+    };
+}
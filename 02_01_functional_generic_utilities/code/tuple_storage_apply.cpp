@@ -1,30 +1,9 @@
+#include "executor.hpp"
+#include "make_task.hpp"
+
 #include <functional>
 #include <thread>
-#include <tuple>
-#include <type_traits>
-#include <utility>
-
-template <typename F, typename... Ts>
-struct task {
-    std::decay_t<F> f;
-    std::tuple<std::decay_t<Ts>...> t;
-
-    void operator()() {
-        std::apply([&](auto&... ts) {
-            f(ts...);
-        }, t);
-        // or if there are no additional arguments to pass to f simply:
-        // std::apply(f, t);
-    }
-};
-
-template <typename F, typename... Ts>
-auto make_task(F&& f, Ts&&... ts) {
-    return task<F, Ts...>{
-        std::forward<F>(f),
-        std::tuple<std::decay_t<Ts>...>(std::forward<Ts>(ts)...)
-    };
-}
+#include <vector>
 
 void fill(int* array, int n, int x) {
     for (int i = 0; i < n; ++i) {
@@ -40,8 +19,9 @@ int main() {
     auto t = make_task(fill, v.data(), v.size(), x);
 
     {
-        // Initialize thread pool etc. to run task
-        std::thread thr(t);
-        thr.join();
+        // Run the task on a pool of threads, see executor.cpp for how it
+        // compares to a thread per task
+        executor pool;
+        pool.submit(t).get();
     }
 }
@@ -0,0 +1,98 @@
+#include "count_allocations.hpp"
+#include "unique_function.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+template <size_t Bytes>
+struct capture {
+    std::array<int, Bytes / sizeof(int)> values;
+
+    int operator()(int x) const { return x + values[0] + values.back(); }
+};
+
+constexpr size_t count = 1000;
+
+// Construct count functions from copies of f into a vector and destroy them
+// again, reps times.
+template <class Function, class F>
+void MeasureConstruct(const std::string& name, size_t reps, const F& f) {
+    std::vector<Function> functions;
+    functions.reserve(count);
+
+    const size_t allocations_before = num_allocations;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        for (size_t idx = 0; idx < count; ++idx) {
+            functions.emplace_back(f);
+        }
+        functions.clear();
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    const size_t allocations = num_allocations - allocations_before;
+
+    std::cout << "  construct " << name << std::chrono::duration<double, std::nano>(end - start).count() / (reps * count)
+              << " ns, " << double(allocations) / (reps * count) << " allocations" << std::endl;
+}
+
+// Call count functions made from f, reps times each.
+template <class Function, class F>
+void MeasureCall(const std::string& name, size_t reps, const F& f) {
+    std::vector<Function> functions;
+    for (size_t idx = 0; idx < count; ++idx) {
+        functions.emplace_back(f);
+    }
+
+    const int expected = int(reps * count) * f(1);
+    int sum = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        for (auto& fun : functions) {
+            sum += fun(1);
+        }
+    }
+    const auto end = std::chrono::high_resolution_clock::now();
+    if (sum != expected) {
+        throw std::logic_error("incorrect result");
+    }
+
+    std::cout << "  call " << name << std::chrono::duration<double, std::nano>(end - start).count() / (reps * count)
+              << " ns" << std::endl;
+}
+
+template <size_t Bytes>
+void Compare(size_t reps) {
+    const capture<Bytes> f{ { 1 } };
+    std::cout << Bytes << " byte capture:" << std::endl;
+    MeasureConstruct<std::function<int(int)>>("std::function:               ", reps, f);
+    MeasureConstruct<unique_function<int(int)>>("unique_function:             ", reps, f);
+    MeasureConstruct<unique_function<int(int), 256>>("unique_function<..., 256>:   ", reps, f);
+    MeasureCall<std::function<int(int)>>("std::function:                    ", reps, f);
+    MeasureCall<unique_function<int(int)>>("unique_function:                  ", reps, f);
+    MeasureCall<unique_function<int(int), 256>>("unique_function<..., 256>:        ", reps, f);
+}
+
+int main() {
+    constexpr size_t reps = 1000;
+
+    // std::function stores up to 16 bytes inline with libstdc++, the
+    // default unique_function 56.
+    Compare<8>(reps);
+    Compare<48>(reps);
+    Compare<128>(reps);
+
+    // Move-only captures, which std::function cannot hold at all.
+    unique_function<int()> f = [p = std::make_unique<int>(42)] { return *p; };
+    unique_function<int()> g = std::move(f);
+    if (f || g() != 42) {
+        throw std::logic_error("incorrect result");
+    }
+}
@@ -0,0 +1,118 @@
+#include "benchmark.hpp"
+#include "cursor.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <span>
+
+// The type erased any_cursor of the slides, with a heap allocated impl and
+// three virtual calls per element.
+template <class T>
+class virtual_any_cursor {
+    struct iface {
+        virtual ~iface(){};
+        virtual T get() const = 0;
+        virtual bool done() const = 0;
+        virtual void next() = 0;
+    };
+
+    template <cursor::Cursor C>
+    struct impl : iface {
+        C cur_;
+        impl(C cur) : cur_(std::move(cur)) {}
+        T get() const { return cursor::get(cur_); }
+        bool done() const { return cursor::done(cur_); }
+        void next() { cursor::next(cur_); }
+    };
+
+    std::unique_ptr<iface> impl_;
+
+public:
+    template <class C>
+    virtual_any_cursor(C cur) : impl_{ new impl<C>(std::move(cur)) } {}
+
+    friend bool cursor_done(virtual_any_cursor const& cur) { return cur.impl_->done(); }
+    friend void cursor_next(virtual_any_cursor& cur) { cur.impl_->next(); }
+    friend T cursor_get(virtual_any_cursor const& cur) { return cur.impl_->get(); }
+};
+
+#ifdef _MSC_VER
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
+
+using value_t = std::uint64_t;
+
+auto pipeline(std::size_t n) {
+    using namespace cursor::pipes;
+    using namespace cursor_library;
+    return numbers_from<value_t>{ 0 } | squared | take(int(n));
+}
+
+// Where type erasure is used, the code that consumes a cursor does not see
+// where it was made, and the cursor can be of more than one type. Otherwise,
+// the compiler can see through the virtual calls: GCC calls the only
+// implementation there is directly, after checking the vtable pointer.
+NOINLINE virtual_any_cursor<value_t> make_virtual(std::size_t n) {
+    if (n == 0) {
+        return cursor_library::numbers_from<value_t>{ 0 };
+    }
+    return pipeline(n);
+}
+
+NOINLINE cursor::any_cursor<value_t> make_any(std::size_t n) {
+    if (n == 0) {
+        return cursor_library::numbers_from<value_t>{ 0 };
+    }
+    return pipeline(n);
+}
+
+value_t sum_batched(cursor::any_cursor<value_t> cur) {
+    std::array<value_t, 256> batch;
+    value_t result = 0;
+    for (std::size_t n; (n = cur.get_batch(batch)) > 0;) {
+        for (std::size_t idx = 0; idx < n; ++idx) {
+            result += batch[idx];
+        }
+    }
+    return result;
+}
+
+int main() {
+    constexpr std::size_t count = 50'000'000;
+
+    value_t expected = 0;
+    for (value_t value = 0; value < count; ++value) {
+        expected += value * value;
+    }
+
+    std::cout << "per element:" << std::endl;
+    measure("    concrete:                ", count, expected, [&] { return sum(pipeline(count)); });
+    measure("    virtual, heap:           ", count, expected, [&] { return sum(make_virtual(count)); });
+    measure("    any_cursor:              ", count, expected, [&] { return sum(make_any(count)); });
+    measure("    any_cursor, get_batch:   ", count, expected, [&] { return sum_batched(make_any(count)); });
+
+    // Short pipelines, where creating the cursor matters.
+    constexpr std::size_t num_short = 10'000'000;
+    constexpr std::size_t short_length = 4;
+    const value_t expected_short = num_short * (0 + 1 + 4 + 9);
+    std::cout << "per element, in pipelines of " << short_length << " elements:" << std::endl;
+    measure("    virtual, heap:           ", num_short * short_length, expected_short, [&] {
+        value_t result = 0;
+        for (std::size_t idx = 0; idx < num_short; ++idx) {
+            result += sum(make_virtual(short_length));
+        }
+        return result;
+    });
+    measure("    any_cursor:              ", num_short * short_length, expected_short, [&] {
+        value_t result = 0;
+        for (std::size_t idx = 0; idx < num_short; ++idx) {
+            result += sum(make_any(short_length));
+        }
+        return result;
+    });
+}
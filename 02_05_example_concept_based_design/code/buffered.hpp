@@ -0,0 +1,188 @@
+#pragma once
+
+#include "cursor.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Adaptors that take elements from a cursor in blocks of n, with get_batch,
+// and hand them out of the block. buffered(n) gets the next block when the
+// current one is used up. prefetch(n) gets blocks on a background thread,
+// up to two ahead, so that a slow source, like a file that is not in the
+// page cache, is read while the pipeline works on the current block.
+namespace cursor_library {
+
+// A cursor over the blocks that Source hands out one after the other. Its
+// fetch(block) replaces the block, and returns false for the last one.
+template <class Source>
+class blocks_impl_ {
+    using value_type = typename Source::value_type;
+
+    Source source_;
+    std::vector<value_type> block_;
+    std::size_t idx_ = 0;
+    bool last_ = false;
+
+    void fetch() {
+        last_ = !source_.fetch(block_);
+        idx_ = 0;
+    }
+
+public:
+    explicit blocks_impl_(Source source) : source_(std::move(source)) {
+        fetch();
+    }
+
+    friend value_type const& cursor_get(blocks_impl_ const& cur) {
+        return cur.block_[cur.idx_];
+    }
+    friend void cursor_next(blocks_impl_& cur) {
+        if (++cur.idx_ == cur.block_.size() && !cur.last_) {
+            cur.fetch();
+        }
+    }
+    friend bool cursor_done(blocks_impl_ const& cur) {
+        return cur.idx_ == cur.block_.size();
+    }
+    friend std::size_t cursor_get_batch(blocks_impl_& cur, std::span<value_type> out) {
+        std::size_t n = 0;
+        while (n < out.size() && cur.idx_ < cur.block_.size()) {
+            const std::size_t count = std::min(out.size() - n, cur.block_.size() - cur.idx_);
+            std::copy_n(cur.block_.begin() + cur.idx_, count, out.begin() + n);
+            cur.idx_ += count;
+            n += count;
+            if (cur.idx_ == cur.block_.size() && !cur.last_) {
+                cur.fetch();
+            }
+        }
+        return n;
+    }
+};
+
+template <Cursor C>
+struct buffered_source_ {
+    using value_type = cursor::value_t<C>;
+
+    C cur_;
+    std::size_t block_size_;
+
+    bool fetch(std::vector<value_type>& block) {
+        block.resize(block_size_);
+        block.resize(cursor::get_batch(cur_, std::span<value_type>(block)));
+        return block.size() == block_size_;
+    }
+};
+
+constexpr inline auto buffered = [](std::size_t n) {
+    return [n]<Cursor C>(C&& cur) {
+        return blocks_impl_<buffered_source_<C>>({ std::forward<C>(cur), std::max<std::size_t>(n, 1) });
+    };
+};
+
+// The producer fills one block while the consumer works on another, and a
+// third one can wait in between. They swap blocks rather than allocate them.
+template <Cursor C>
+class prefetch_source_ {
+public:
+    using value_type = cursor::value_t<C>;
+
+    template <Cursor D>
+    prefetch_source_(D&& cur, std::size_t block_size)
+        : state_(std::make_unique<state>(std::forward<D>(cur), block_size)) {
+        state_->thread_ = std::thread([s = state_.get()] { s->produce(); });
+    }
+
+    bool fetch(std::vector<value_type>& block) {
+        state& s = *state_;
+        {
+            std::unique_lock lock(s.mutex_);
+            s.changed_.wait(lock, [&] { return s.has_ready_; });
+            if (s.error_) {
+                std::rethrow_exception(s.error_);
+            }
+            std::swap(block, s.ready_);
+            s.has_ready_ = false;
+        }
+        s.changed_.notify_all();
+        return block.size() == s.block_size_;
+    }
+
+private:
+    struct state {
+        C cur_;
+        std::size_t block_size_;
+        std::mutex mutex_;
+        std::condition_variable changed_;
+        std::vector<value_type> ready_;
+        bool has_ready_ = false;
+        bool stop_ = false;
+        std::exception_ptr error_;
+        std::thread thread_;
+
+        template <Cursor D>
+        state(D&& cur, std::size_t block_size) : cur_(std::forward<D>(cur)), block_size_(block_size) {}
+
+        ~state() {
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            changed_.notify_all();
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+
+        // Hands block, or error, to the consumer once it took the previous
+        // block. Returns false if the consumer is gone.
+        bool publish(std::vector<value_type>& block, std::exception_ptr error = nullptr) {
+            std::unique_lock lock(mutex_);
+            changed_.wait(lock, [this] { return !has_ready_ || stop_; });
+            if (stop_) {
+                return false;
+            }
+            std::swap(block, ready_);
+            error_ = std::move(error);
+            has_ready_ = true;
+            lock.unlock();
+            changed_.notify_all();
+            return true;
+        }
+
+        void produce() {
+            std::vector<value_type> filling;
+            try {
+                for (bool last = false; !last;) {
+                    filling.resize(block_size_);
+                    filling.resize(cursor::get_batch(cur_, std::span<value_type>(filling)));
+                    last = filling.size() < block_size_;
+                    if (!publish(filling)) {
+                        return;
+                    }
+                }
+            }
+            catch (...) {
+                filling.clear();
+                publish(filling, std::current_exception());
+            }
+        }
+    };
+
+    std::unique_ptr<state> state_;
+};
+
+constexpr inline auto prefetch = [](std::size_t n) {
+    return [n]<Cursor C>(C&& cur) {
+        return blocks_impl_<prefetch_source_<C>>(prefetch_source_<C>(std::forward<C>(cur), std::max<std::size_t>(n, 1)));
+    };
+};
+
+} // namespace cursor_library
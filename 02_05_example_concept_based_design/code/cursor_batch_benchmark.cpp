@@ -0,0 +1,83 @@
+#include "benchmark.hpp"
+#include "cursor.hpp"
+#include "filter.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Sums cursor pipelines one element at a time and in batches, where each
+// stage runs a loop over a buffer that the compiler can vectorize. Where the
+// whole pipeline is inlined into the sum, the compiler may vectorize the
+// element-wise loop as well; behind an any_cursor it cannot.
+
+#ifdef _MSC_VER
+#define NOINLINE __declspec(noinline)
+#else
+#define NOINLINE __attribute__((noinline))
+#endif
+
+using value_t = std::uint64_t;
+
+// Two cursor types, so that the compiler cannot see through the type erasure.
+NOINLINE cursor::any_cursor<value_t> make_any(std::size_t n) {
+    using namespace cursor::pipes;
+    using namespace cursor_library;
+    if (n == 0) {
+        return numbers_from<value_t>{ 0 };
+    }
+    return numbers_from<value_t>{ 0 } | squared | take(int(n));
+}
+
+template <std::size_t BatchSize, cursor::Cursor C>
+value_t sum_batched(C cur) {
+    std::array<value_t, BatchSize> batch;
+    value_t result = 0;
+    for (std::size_t n; (n = cursor::get_batch(cur, std::span<value_t>(batch))) > 0;) {
+        for (std::size_t idx = 0; idx < n; ++idx) {
+            result += batch[idx];
+        }
+    }
+    return result;
+}
+
+int main() {
+    using namespace cursor::pipes;
+    using namespace cursor_library;
+
+    constexpr std::size_t count = 100'000'000;
+    constexpr auto odd = [](value_t x) { return x % 2 == 1; };
+
+    value_t expected = 0;
+    value_t expected_odd = 0;
+    for (value_t value = 0; value < count; ++value) {
+        expected += value * value;
+        expected_odd += (2 * value + 1) * (2 * value + 1);
+    }
+
+    std::cout << "numbers_from | squared | take:" << std::endl;
+    measure("    loop:                ", count, expected, [&] {
+        value_t result = 0;
+        for (value_t value = 0; value < count; ++value) {
+            result += value * value;
+        }
+        return result;
+    });
+    measure("    element-wise:        ", count, expected,
+            [&] { return sum(numbers_from<value_t>{ 0 } | squared | take(int(count))); });
+    measure("    batches of 16:       ", count, expected,
+            [&] { return sum_batched<16>(numbers_from<value_t>{ 0 } | squared | take(int(count))); });
+    measure("    batches of 256:      ", count, expected,
+            [&] { return sum_batched<256>(numbers_from<value_t>{ 0 } | squared | take(int(count))); });
+
+    std::cout << "numbers_from | squared | take, as any_cursor:" << std::endl;
+    measure("    element-wise:        ", count, expected, [&] { return sum(make_any(count)); });
+    measure("    batches of 256:      ", count, expected, [&] { return sum_batched<256>(make_any(count)); });
+
+    std::cout << "numbers_from | filter(odd) | squared | take:" << std::endl;
+    measure("    element-wise:        ", count, expected_odd,
+            [&] { return sum(numbers_from<value_t>{ 0 } | filter(odd) | squared | take(int(count))); });
+    measure("    batches of 256:      ", count, expected_odd,
+            [&] { return sum_batched<256>(numbers_from<value_t>{ 0 } | filter(odd) | squared | take(int(count))); });
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "cursor.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Cursors over the contents of a file, which is mapped into memory instead of
+// read into buffers. The kernel reads the pages as the cursor reaches them,
+// and reads ahead since the mapping is advised to be read sequentially.
+// Copies of a cursor share the mapping.
+namespace cursor_library {
+
+// A read-only mapping of a whole file.
+class mapped_file {
+public:
+    explicit mapped_file(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(errno, std::system_category(), "cannot open " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) < 0) {
+            const int error = errno;
+            ::close(fd);
+            throw std::system_error(error, std::system_category(), "cannot stat " + path);
+        }
+        size_ = std::size_t(st.st_size);
+        // An empty file cannot be mapped.
+        if (size_ > 0) {
+            void* data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                const int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::system_category(), "cannot map " + path);
+            }
+            ::madvise(data, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const char*>(data);
+        }
+        ::close(fd);
+    }
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() {
+        if (data_) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+    }
+
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+};
+
+// The lines of a text file, without their '\n', as views into the mapping.
+class file_lines {
+    std::shared_ptr<const mapped_file> file_;
+    std::size_t begin_ = 0; // Of the current line.
+    std::size_t end_ = 0;   // Of the current line, at its '\n' or the end of the file.
+
+    void find_end() {
+        const std::size_t size = file_->size();
+        const void* newline = begin_ < size ? std::memchr(file_->data() + begin_, '\n', size - begin_) : nullptr;
+        end_ = newline ? std::size_t(static_cast<const char*>(newline) - file_->data()) : size;
+    }
+
+public:
+    explicit file_lines(const std::string& path) : file_(std::make_shared<const mapped_file>(path)) {
+        find_end();
+    }
+
+    friend std::string_view cursor_get(file_lines const& cur) {
+        return { cur.file_->data() + cur.begin_, cur.end_ - cur.begin_ };
+    }
+    friend void cursor_next(file_lines& cur) {
+        cur.begin_ = std::min(cur.end_ + 1, cur.file_->size());
+        cur.find_end();
+    }
+    friend bool cursor_done(file_lines const& cur) {
+        return cur.begin_ == cur.file_->size();
+    }
+};
+static_assert(cursor::Cursor<file_lines>);
+
+// The records of a binary file of Ts, copied out of the mapping, which does
+// not need to be aligned for T. A partial record at the end is ignored. It
+// jumps, hands out batches and splits, since records are at known offsets.
+template <class T>
+    requires std::is_trivially_copyable_v<T>
+class file_records {
+    std::shared_ptr<const mapped_file> file_;
+    std::size_t idx_ = 0;
+    std::size_t end_ = 0;
+
+public:
+    explicit file_records(const std::string& path)
+        : file_(std::make_shared<const mapped_file>(path)), end_(file_->size() / sizeof(T)) {}
+
+    friend T cursor_get(file_records const& cur) {
+        T value;
+        std::memcpy(&value, cur.file_->data() + cur.idx_ * sizeof(T), sizeof(T));
+        return value;
+    }
+    friend void cursor_next(file_records& cur) { ++cur.idx_; }
+    friend bool cursor_done(file_records const& cur) { return cur.idx_ == cur.end_; }
+    friend std::size_t cursor_get_batch(file_records& cur, std::span<T> out) {
+        const std::size_t n = std::min(out.size(), cur.end_ - cur.idx_);
+        if (n > 0) {
+            std::memcpy(out.data(), cur.file_->data() + cur.idx_ * sizeof(T), n * sizeof(T));
+        }
+        cur.idx_ += n;
+        return n;
+    }
+    friend void cursor_advance(file_records& cur, std::size_t n) { cur.idx_ += std::min(n, cur.end_ - cur.idx_); }
+    friend std::size_t cursor_size(file_records const& cur) { return cur.end_ - cur.idx_; }
+    friend file_records cursor_split(file_records& cur) {
+        file_records back = cur;
+        back.idx_ = cur.idx_ + (cur.end_ - cur.idx_) / 2;
+        cur.end_ = back.idx_;
+        return back;
+    }
+};
+static_assert(cursor::SplittableCursor<file_records<double>>);
+
+} // namespace cursor_library
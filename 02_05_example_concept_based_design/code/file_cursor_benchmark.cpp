@@ -0,0 +1,137 @@
+#include "benchmark.hpp"
+#include "buffered.hpp"
+#include "cursor.hpp"
+#include "file_cursor.hpp"
+#include "filter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Streams a text file and a binary file of records through cursor pipelines,
+// straight from the mapping, with buffered and with prefetch. Each pipeline
+// starts with the file out of the page cache, so it is limited by the disk
+// unless the pipeline is slower, and prefetch lets the two overlap.
+
+constexpr std::size_t file_size = std::size_t(256) << 20;
+constexpr std::size_t block_size = 4096;
+
+struct particle {
+    double x, y, z;
+    double mass;
+};
+
+// So that reads come from the disk rather than from the page cache. Pages
+// that are not written back yet are not dropped, so the file is synced first.
+void drop_cache(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    if (fdatasync(fd) < 0) {
+        close(fd);
+        throw std::runtime_error("cannot sync " + path);
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// Like measure, but from a cold page cache and in MB/s of the file.
+template <class T, class Fun>
+void measure_file(const std::string& name, const std::string& path, T expected, Fun&& fun) {
+    drop_cache(path);
+    T result{};
+    const double ns = ns_per_element(file_size, [&] { result = fun(); });
+    if (result != expected) {
+        throw std::logic_error("incorrect result");
+    }
+    std::cout << name << 1000 / ns << " MB/s" << std::endl;
+}
+
+template <cursor::Cursor C>
+std::size_t count(C cur) {
+    std::size_t result = 0;
+    for (; !cursor::done(cur); cursor::next(cur)) {
+        ++result;
+    }
+    return result;
+}
+
+void run(const std::string& text_path, const std::string& records_path) {
+    using namespace cursor::pipes;
+    using namespace cursor_library;
+
+    const auto matches = [](std::string_view line) { return line.ends_with("42"); };
+    const auto heavy = [](const particle& p) { return p.mass > 0.5; };
+    const auto mass = [](const particle& p) { return p.mass; };
+
+    std::size_t expected_lines = 0;
+    double expected_mass = 0;
+    {
+        std::ofstream text(text_path);
+        std::string line;
+        for (std::size_t idx = 0, size = 0; size < file_size; ++idx) {
+            line = "particle " + std::to_string(idx) + " " + std::to_string(idx * 2654435761 % 1000003) + "\n";
+            text << line;
+            size += line.size();
+            expected_lines += matches(std::string_view(line).substr(0, line.size() - 1));
+        }
+
+        std::ofstream records(records_path, std::ios::binary);
+        for (std::size_t idx = 0; idx < file_size / sizeof(particle); ++idx) {
+            const double value = double(idx);
+            const particle p{ value, value + 1, value + 2, double(idx % 1000) / 1000 };
+            records.write(reinterpret_cast<const char*>(&p), sizeof(p));
+            expected_mass += heavy(p) ? mass(p) : 0;
+        }
+        if (!text || !records) {
+            throw std::runtime_error("cannot write " + text_path + " and " + records_path);
+        }
+    }
+
+    std::cout << "file_lines | filter | take(5) | dump:" << std::endl;
+    file_lines(text_path) | filter(matches) | take(5) | dump;
+
+    std::cout << "file_lines | filter, count:" << std::endl;
+    measure_file("    direct:       ", text_path, expected_lines,
+                 [&] { return count(file_lines(text_path) | filter(matches)); });
+    measure_file("    buffered:     ", text_path, expected_lines,
+                 [&] { return count(file_lines(text_path) | buffered(block_size) | filter(matches)); });
+    measure_file("    prefetch:     ", text_path, expected_lines,
+                 [&] { return count(file_lines(text_path) | prefetch(block_size) | filter(matches)); });
+
+    std::cout << "file_records | filter | transform, sum:" << std::endl;
+    measure_file("    direct:       ", records_path, expected_mass,
+                 [&] { return sum(file_records<particle>(records_path) | filter(heavy) | transform(mass)); });
+    measure_file("    buffered:     ", records_path, expected_mass,
+                 [&] { return sum(file_records<particle>(records_path) | buffered(block_size) | filter(heavy) | transform(mass)); });
+    measure_file("    prefetch:     ", records_path, expected_mass,
+                 [&] { return sum(file_records<particle>(records_path) | prefetch(block_size) | filter(heavy) | transform(mass)); });
+}
+
+int main(int argc, char** argv) {
+    const std::string prefix = argc > 1 ? argv[1] : "file_cursor";
+    const std::string text_path = prefix + ".txt";
+    const std::string records_path = prefix + ".dat";
+
+    // Removes the files also if writing them or a pipeline throws.
+    const auto remove_files = [&] {
+        unlink(text_path.c_str());
+        unlink(records_path.c_str());
+    };
+    try {
+        run(text_path, records_path);
+    }
+    catch (...) {
+        remove_files();
+        throw;
+    }
+    remove_files();
+}
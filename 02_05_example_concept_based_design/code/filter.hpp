@@ -0,0 +1,125 @@
+#pragma once
+
+#include "cursor.hpp"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+// filter, the solution of the first exercise, with support for batches. It is
+// not part of cursor.hpp, which the exercise starts from.
+namespace cursor_library {
+
+template <Cursor C, class Fun>
+class filter_impl_ {
+    C cur_;
+    Fun fun_;
+
+    // Keeps the cursor on an element that passes the filter, or done.
+    void advance_to_next() {
+        for (; !cursor::done(cur_) && !fun_(cursor::get(cur_)); cursor::next(cur_))
+            ;
+    }
+
+    // Moves the elements of in that pass the filter to out, which can be the
+    // same memory, without a branch per element. If first_passes, the first
+    // element is the one advance_to_next already tested, and is not tested again.
+    template <class U, class T>
+    std::size_t compact(std::span<U> in, T* out, bool first_passes) {
+        std::size_t n = 0;
+        std::size_t idx = 0;
+        if (first_passes && !in.empty()) {
+            out[n++] = in[idx++];
+        }
+        for (; idx < in.size(); ++idx) {
+            out[n] = in[idx];
+            n += bool(fun_(in[idx]));
+        }
+        return n;
+    }
+
+public:
+    template <Cursor D>
+    filter_impl_(D&& cur, Fun fun) : cur_{ std::forward<D>(cur) }, fun_{ std::move(fun) } {
+        advance_to_next();
+    }
+
+    // The elements that pass both fun_ and fun, from one cursor.
+    template <class G>
+    auto and_filter(G fun) && {
+        auto both = [f = std::move(fun_), g = std::move(fun)](auto const& value) -> bool {
+            return f(value) && g(value);
+        };
+        return filter_impl_<C, decltype(both)>(std::forward<C>(cur_), std::move(both));
+    }
+
+    friend decltype(auto) cursor_get(filter_impl_ const& cur) {
+        return cursor::get(cur.cur_);
+    }
+    friend bool cursor_done(filter_impl_ const& cur) {
+        return cursor::done(cur.cur_);
+    }
+    friend void cursor_next(filter_impl_& cur) {
+        cursor::next(cur.cur_);
+        cur.advance_to_next();
+    }
+    // Gets batches from the underlying cursor until enough elements passed,
+    // in place in out if it has the same element type.
+    template <class T>
+    friend std::size_t cursor_get_batch(filter_impl_& cur, std::span<T> out) {
+        using U = cursor::value_t<C>;
+        std::size_t n = 0;
+        for (bool first = true; n < out.size(); first = false) {
+            std::size_t wanted, got;
+            if constexpr (std::is_same_v<U, T>) {
+                const auto rest = out.subspan(n);
+                wanted = rest.size();
+                got = cursor::get_batch(cur.cur_, rest);
+                n += cur.compact(rest.first(got), out.data() + n, first);
+            }
+            else {
+                // Elements that pass cannot overflow out.
+                U buffer[cursor::batch_size];
+                wanted = std::min(out.size() - n, cursor::batch_size);
+                got = cursor::get_batch(cur.cur_, std::span<U>(buffer, wanted));
+                n += cur.compact(std::span<U>(buffer, got), out.data() + n, first);
+            }
+            if (got < wanted) {
+                break;
+            }
+        }
+        cur.advance_to_next();
+        return n;
+    }
+    // The size of the underlying cursor is an upper bound.
+    friend std::size_t cursor_size(filter_impl_ const& cur)
+        requires cursor::SplittableCursor<C>
+    {
+        return cursor::size(cur.cur_);
+    }
+    friend filter_impl_ cursor_split(filter_impl_& cur)
+        requires cursor::SplittableCursor<C> && std::copy_constructible<Fun>
+    {
+        return filter_impl_(cursor::split(cur.cur_), cur.fun_);
+    }
+};
+
+constexpr inline auto filter = [](auto fun) {
+    return [fun = std::move(fun)]<Cursor C>(C&& cur) {
+#ifndef CURSOR_NO_FUSION
+        // A filter of a temporary filter tests both predicates in one cursor.
+        if constexpr (requires { std::forward<C>(cur).and_filter(fun); }) {
+            return std::forward<C>(cur).and_filter(fun);
+        }
+        else
+#endif
+        {
+            return filter_impl_<C, decltype(fun)>(std::forward<C>(cur), std::move(fun));
+        }
+    };
+};
+
+} // namespace cursor_library
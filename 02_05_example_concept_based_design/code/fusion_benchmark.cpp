@@ -0,0 +1,77 @@
+#include "benchmark.hpp"
+#include "cursor.hpp"
+#include "filter.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+// Deep pipelines of transforms and filters. CMake builds this file twice,
+// as 02_05_fusion_benchmark, where adjacent stages are fused, and as
+// 02_05_fusion_benchmark_unfused, with CURSOR_NO_FUSION. Time the build of
+// both targets for the compile time, and run both for the run time.
+
+using value_t = std::uint64_t;
+
+constexpr std::size_t depth = 64;
+
+// A different stage type for each I.
+template <std::size_t I>
+constexpr inline auto add = cursor_library::transform([](value_t x) { return x + (I % 2); });
+
+template <std::size_t I>
+constexpr inline auto not_multiple = cursor_library::filter([](value_t x) { return x % (I + 2) != 0 || I % 2 == 0; });
+
+template <cursor::Cursor C, std::size_t... I>
+auto add_all(C&& cur, std::index_sequence<I...>) {
+    using namespace cursor::pipes;
+    return (std::forward<C>(cur) | ... | add<I>);
+}
+
+template <cursor::Cursor C, std::size_t... I>
+auto filter_all(C&& cur, std::index_sequence<I...>) {
+    using namespace cursor::pipes;
+    return (std::forward<C>(cur) | ... | not_multiple<I>);
+}
+
+#ifndef CURSOR_NO_FUSION
+// One transform_impl_ around numbers_from.
+static_assert(std::is_same_v<decltype(add_all(cursor_library::numbers_from<value_t>{ 0 },
+                                              std::make_index_sequence<depth>{})
+                                          .cur_),
+                             cursor_library::numbers_from<value_t>>);
+#endif
+
+int main() {
+    using namespace cursor::pipes;
+    using namespace cursor_library;
+
+    constexpr std::size_t count = 20'000'000;
+
+#ifdef CURSOR_NO_FUSION
+    std::cout << "nested stages:" << std::endl;
+#else
+    std::cout << "fused stages:" << std::endl;
+#endif
+
+    // The odd stages add 1.
+    const value_t expected_add = count * (count - 1) / 2 + count * (depth / 2);
+    measure("    numbers_from | take | 64 x transform: ", count, expected_add, [&] {
+        return sum(add_all(numbers_from<value_t>{ 0 } | take(int(count)), std::make_index_sequence<depth>{}));
+    });
+
+    // The odd stages drop multiples of I + 2.
+    value_t expected_filter = 0;
+    for (value_t value = 0; value < count; ++value) {
+        bool pass = true;
+        for (std::size_t idx = 1; idx < depth; idx += 2) {
+            pass = pass && value % (idx + 2) != 0;
+        }
+        expected_filter += pass ? value : 0;
+    }
+    measure("    numbers_from | take | 64 x filter:    ", count, expected_filter, [&] {
+        return sum(filter_all(numbers_from<value_t>{ 0 } | take(int(count)), std::make_index_sequence<depth>{}));
+    });
+}
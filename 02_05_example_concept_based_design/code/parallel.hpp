@@ -0,0 +1,132 @@
+#pragma once
+
+#include "cursor.hpp"
+#include "executor.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+// Parallel cursor algorithms over splittable cursors, on the threads of an
+// executor. The cursor is split in halves until the pieces have at most grain
+// elements, each piece is traversed serially, and the calling thread takes
+// part and waits until all pieces are done. An exception from any piece is
+// rethrown by the caller, after the others finished. Like executor::wait,
+// they must not be called from a task of the same executor.
+namespace cursor_library {
+using cursor::SplittableCursor;
+
+namespace parallel_impl_ {
+    // Number of pieces still running, and the first exception.
+    struct join_state {
+        std::mutex mutex_;
+        std::condition_variable done_;
+        std::size_t pending_ = 1;
+        std::exception_ptr error_;
+
+        void finish(std::exception_ptr error) {
+            // Notifies under the lock, since the waiting thread destroys the
+            // state as soon as it can take the lock.
+            std::lock_guard lock(mutex_);
+            if (error && !error_) {
+                error_ = std::move(error);
+            }
+            if (--pending_ == 0) {
+                done_.notify_all();
+            }
+        }
+
+        void wait() {
+            std::unique_lock lock(mutex_);
+            done_.wait(lock, [this] { return pending_ == 0; });
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+        }
+    };
+
+    // Posts the second half of cur until it has at most grain elements left,
+    // then calls leaf on it. Each posted half does the same.
+    template <SplittableCursor C, class Leaf>
+    void run_piece(executor& ex, join_state& state, C cur, std::size_t grain, Leaf& leaf) {
+        std::exception_ptr error;
+        try {
+            while (cursor::size(cur) > grain) {
+                C back = cursor::split(cur);
+                {
+                    std::lock_guard lock(state.mutex_);
+                    ++state.pending_;
+                }
+                try {
+                    ex.post([&ex, &state, back = std::move(back), grain, &leaf]() mutable {
+                        run_piece(ex, state, std::move(back), grain, leaf);
+                    });
+                }
+                catch (...) {
+                    state.finish(nullptr);
+                    throw;
+                }
+            }
+            leaf(cur);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        state.finish(std::move(error));
+    }
+
+    template <SplittableCursor C, class Leaf>
+    void fork_join(executor& ex, C cur, std::size_t grain, Leaf& leaf) {
+        join_state state;
+        run_piece(ex, state, std::move(cur), std::max<std::size_t>(grain, 1), leaf);
+        state.wait();
+    }
+
+    // About eight pieces per thread, to balance pieces of different costs.
+    template <SplittableCursor C>
+    std::size_t default_grain(executor& ex, C const& cur) {
+        return std::max<std::size_t>(1024, cursor::size(cur) / (8 * ex.size()));
+    }
+} // namespace parallel_impl_
+
+// Calls fun on every element, in no particular order.
+template <SplittableCursor C, class Fun>
+void parallel_for_each(executor& ex, C cur, Fun fun, std::size_t grain = 0) {
+    if (grain == 0) {
+        grain = parallel_impl_::default_grain(ex, cur);
+    }
+    auto leaf = [&fun](C& piece) {
+        for (; !cursor::done(piece); cursor::next(piece)) {
+            fun(cursor::get(piece));
+        }
+    };
+    parallel_impl_::fork_join(ex, std::move(cur), grain, leaf);
+}
+
+// Combines init and all elements with op, in no particular order and
+// grouping, so op must be associative and commutative, like for std::reduce.
+template <SplittableCursor C, class T, class Op>
+T parallel_reduce(executor& ex, C cur, T init, Op op, std::size_t grain = 0) {
+    if (grain == 0) {
+        grain = parallel_impl_::default_grain(ex, cur);
+    }
+    std::mutex mutex;
+    T result = std::move(init);
+    auto leaf = [&](C& piece) {
+        if (cursor::done(piece)) {
+            return;
+        }
+        T partial = cursor::get(piece);
+        for (cursor::next(piece); !cursor::done(piece); cursor::next(piece)) {
+            partial = op(std::move(partial), cursor::get(piece));
+        }
+        std::lock_guard lock(mutex);
+        result = op(std::move(result), std::move(partial));
+    };
+    parallel_impl_::fork_join(ex, std::move(cur), grain, leaf);
+    return result;
+}
+} // namespace cursor_library
@@ -0,0 +1,90 @@
+#include "benchmark.hpp"
+#include "cursor.hpp"
+#include "filter.hpp"
+#include "parallel.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reduces transform and filter pipelines, and fills a vector, serially and
+// with parallel_reduce and parallel_for_each on executors of growing size.
+
+using value_t = std::uint64_t;
+
+static_assert(cursor::SplittableCursor<cursor_library::take_impl_<cursor_library::numbers_from<int>>>);
+static_assert(!cursor::SplittableCursor<cursor_library::numbers_from<int>>);
+
+void report(const std::string& name, std::size_t nthreads, double ns, double serial_ns) {
+    std::cout << name << nthreads << " threads: " << ns << " ns/element, speedup " << serial_ns / ns << std::endl;
+}
+
+int main() {
+    using namespace cursor::pipes;
+    using namespace cursor_library;
+
+    constexpr std::size_t count = 100'000'000;
+    // Not an integer operation, so that each element costs a little.
+    constexpr auto root = [](value_t x) { return value_t(std::sqrt(double(x))); };
+    constexpr auto odd = [](value_t x) { return x % 2 == 1; };
+
+    const auto pipeline = [&] { return numbers_from<value_t>{ 0 } | take(int(count)) | transform(root); };
+    const auto filtered = [&] { return numbers_from<value_t>{ 0 } | take(int(count)) | filter(odd) | transform(root); };
+
+    value_t expected = 0;
+    value_t expected_filtered = 0;
+    const double serial_ns = ns_per_element(count, [&] {
+        for (auto cur = pipeline(); !cursor::done(cur); cursor::next(cur)) {
+            expected += cursor::get(cur);
+        }
+    });
+    const double serial_filtered_ns = ns_per_element(count, [&] {
+        for (auto cur = filtered(); !cursor::done(cur); cursor::next(cur)) {
+            expected_filtered += cursor::get(cur);
+        }
+    });
+    std::vector<double> out(count);
+    const double serial_for_each_ns = ns_per_element(count, [&] {
+        for (std::size_t idx = 0; idx < count; ++idx) {
+            out[idx] = std::sqrt(double(idx));
+        }
+    });
+    std::cout << "serial: " << serial_ns << ", filtered " << serial_filtered_ns << ", for_each "
+              << serial_for_each_ns << " ns/element" << std::endl;
+
+    const std::size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (std::size_t nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        executor ex(nthreads);
+
+        value_t result = 0;
+        const double ns =
+            ns_per_element(count, [&] { result = parallel_reduce(ex, pipeline(), value_t(0), std::plus<>{}); });
+        if (result != expected) {
+            throw std::logic_error("incorrect result");
+        }
+        report("    take | transform:          ", nthreads, ns, serial_ns);
+
+        const double filtered_ns =
+            ns_per_element(count, [&] { result = parallel_reduce(ex, filtered(), value_t(0), std::plus<>{}); });
+        if (result != expected_filtered) {
+            throw std::logic_error("incorrect result");
+        }
+        report("    take | filter | transform: ", nthreads, filtered_ns, serial_filtered_ns);
+
+        std::vector<double> parallel_out(count);
+        const double for_each_ns = ns_per_element(count, [&] {
+            parallel_for_each(ex, numbers_from<std::size_t>{ 0 } | take(int(count)),
+                              [&](std::size_t idx) { parallel_out[idx] = std::sqrt(double(idx)); });
+        });
+        if (parallel_out != out) {
+            throw std::logic_error("incorrect result");
+        }
+        report("    for_each:                  ", nthreads, for_each_ns, serial_for_each_ns);
+    }
+}
@@ -0,0 +1,91 @@
+#include "cursor.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <utility>
+#include <vector>
+
+// The numbers from value to end, with Size bytes of padding. Counts the live
+// objects, to check that any_cursor destroys what it stores.
+template <std::size_t Size>
+struct counted {
+    static inline int live = 0;
+
+    int value_;
+    int end_;
+    std::array<std::byte, Size> padding_{};
+
+    counted(int value, int end) : value_(value), end_(end) { ++live; }
+    counted(counted const& other) noexcept : value_(other.value_), end_(other.end_) { ++live; }
+    ~counted() { --live; }
+
+    friend int cursor_get(counted const& cur) { return cur.value_; }
+    friend void cursor_next(counted& cur) { ++cur.value_; }
+    friend bool cursor_done(counted const& cur) { return cur.value_ == cur.end_; }
+};
+
+const std::vector<int> expected{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+
+template <class Any>
+std::vector<int> to_vector(Any cur) {
+    std::vector<int> res;
+    for (; !cursor::done(cur); cursor::next(cur)) {
+        res.push_back(cursor::get(cur));
+    }
+    return res;
+}
+
+template <class Any>
+std::vector<int> to_vector_batched(Any cur) {
+    std::vector<int> res;
+    std::array<int, 4> batch;
+    for (std::size_t n = batch.size(); n == batch.size();) {
+        n = cur.get_batch(batch);
+        res.insert(res.end(), batch.begin(), batch.begin() + n);
+    }
+    return res;
+}
+
+// The numbers 0 to 9 from make(), as an Any.
+template <class Any, class Make>
+void check(Make make) {
+    assert(to_vector(Any(make())) == expected);
+    assert(to_vector_batched(Any(make())) == expected);
+
+    Any skipping(make());
+    assert(skipping.next_n(3) == 3);
+    assert(cursor::get(skipping) == 3);
+    assert(skipping.next_n(20) == 7);
+    assert(cursor::done(skipping));
+
+    Any first(make());
+    cursor::next(first);
+    Any second(std::move(first));
+    assert(cursor::get(second) == 1);
+    Any third(make());
+    third = std::move(second);
+    assert(to_vector(std::move(third)) == std::vector<int>(expected.begin() + 1, expected.end()));
+}
+
+int main() {
+    using namespace cursor::pipes;
+    using namespace cursor_library;
+    using any = cursor::any_cursor<int>;
+
+    static_assert(sizeof(counted<8>) <= 4 * sizeof(void*));
+    check<any>([] { return counted<8>(0, 10); });
+    assert(counted<8>::live == 0);
+
+    static_assert(sizeof(counted<64>) > 4 * sizeof(void*));
+    check<any>([] { return counted<64>(0, 10); });
+    assert(counted<64>::live == 0);
+
+    // Always on the heap.
+    check<cursor::any_cursor<int, 0>>([] { return counted<8>(0, 10); });
+    assert(counted<8>::live == 0);
+
+    // Batches from a cursor that hands them out itself.
+    check<any>([] { return numbers_from(0) | take(10); });
+}
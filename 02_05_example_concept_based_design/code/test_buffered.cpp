@@ -0,0 +1,79 @@
+#include "buffered.hpp"
+#include "cursor.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+constexpr std::size_t block_size = 4;
+
+std::vector<int> iota(int n) {
+    std::vector<int> res;
+    for (int value = 0; value < n; ++value) {
+        res.push_back(value);
+    }
+    return res;
+}
+
+template <cursor::Cursor C>
+std::vector<int> to_vector(C cur) {
+    std::vector<int> res;
+    for (; !cursor::done(cur); cursor::next(cur)) {
+        res.push_back(cursor::get(cur));
+    }
+    return res;
+}
+
+template <cursor::Cursor C>
+std::vector<int> to_vector_batched(C cur) {
+    std::vector<int> res;
+    std::array<int, 3> batch;
+    for (std::size_t n = batch.size(); n == batch.size();) {
+        n = cursor::get_batch(cur, std::span<int>(batch));
+        res.insert(res.end(), batch.begin(), batch.begin() + n);
+    }
+    return res;
+}
+
+// Runs buffered or prefetch, as adaptor, on sources of different lengths.
+template <class Adaptor>
+void check(Adaptor adaptor) {
+    using namespace cursor::pipes;
+    using namespace cursor_library;
+
+    // Ending in a full block, in a partial block, and right away.
+    for (int n : { 4 * int(block_size), 4 * int(block_size) + 1, 0 }) {
+        assert(to_vector(numbers_from(0) | take(n) | adaptor(block_size)) == iota(n));
+        assert(to_vector_batched(numbers_from(0) | take(n) | adaptor(block_size)) == iota(n));
+    }
+
+    // Only the first elements of an endless source.
+    assert(to_vector(numbers_from(0) | adaptor(block_size) | take(10)) == iota(10));
+
+    // An exception from the source, in the first block and in a later one,
+    // reaches the consumer.
+    for (int throw_at : { 2, 10 }) {
+        const auto source = [throw_at](int value) {
+            if (value == throw_at) {
+                throw std::runtime_error("throw_at");
+            }
+            return value;
+        };
+        bool thrown = false;
+        try {
+            to_vector(numbers_from(0) | take(20) | transform(source) | adaptor(block_size));
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+}
+
+int main() {
+    check(cursor_library::buffered);
+    check(cursor_library::prefetch);
+}
@@ -0,0 +1,59 @@
+#include "cursor.hpp"
+#include "executor.hpp"
+#include "parallel.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+
+constexpr int count = 100'000;
+constexpr std::size_t grain = 100;
+
+int main() {
+    using namespace cursor::pipes;
+    using namespace cursor_library;
+
+    const auto throw_at = [](long value) {
+        if (value == 777) {
+            throw std::runtime_error("777");
+        }
+        return value;
+    };
+
+    for (std::size_t nthreads : { 1, 4 }) {
+        executor ex(nthreads);
+
+        const long sum = parallel_reduce(ex, numbers_from(0L) | take(count), 0L, std::plus<>{}, grain);
+        assert(sum == long(count) * (count - 1) / 2);
+        assert(parallel_reduce(ex, numbers_from(0L) | take(0), 42L, std::plus<>{}, grain) == 42);
+
+        std::vector<int> visits(count);
+        parallel_for_each(ex, numbers_from(0) | take(count), [&](int idx) { ++visits[idx]; }, grain);
+        assert(visits == std::vector<int>(count, 1));
+        parallel_for_each(ex, numbers_from(0) | take(0), [](int) { assert(false); }, grain);
+
+        // The exception of one piece is rethrown after all pieces finished,
+        // and the executor can be used again.
+        bool thrown = false;
+        try {
+            parallel_reduce(ex, numbers_from(0L) | take(count) | transform(throw_at), 0L, std::plus<>{}, grain);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        thrown = false;
+        try {
+            parallel_for_each(ex, numbers_from(0L) | take(count), [&](long value) { throw_at(value); }, grain);
+        }
+        catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        assert(parallel_reduce(ex, numbers_from(0L) | take(count), 0L, std::plus<>{}, grain) == sum);
+    }
+}
@@ -1,71 +1,248 @@
+#include "cache_info.hpp"
+#include "perf_counters.hpp"
+
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <immintrin.h>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <new>
 #include <numeric>
 #include <span>
+#include <stdexcept>
+#include <string>
 #include <thread>
 #include <vector>
 
+#if defined(_MSC_VER) && !defined(__clang__)
+    #include <intrin.h>
+    // MSVC lets us use any intrinsic without enabling the ISA for the whole file.
+    #define TARGET(isa)
+#else
+    #include <x86intrin.h>
+    // Compile just this function for the given ISA, the rest of the binary
+    // stays baseline x86-64 and runs on any machine.
+    #define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+
+// The kernels all do the same thing: OR together every element of the block
+// with 4 independent loads per iteration. They only differ in vector width.
+// They return the lowest 64 bits of the accumulator to check the result.
+using ReadKernel = int64_t (*)(std::span<const int64_t> values, size_t reps);
+
+
+TARGET("sse2") int64_t ReadBlockSse2(std::span<const int64_t> values, size_t reps) {
+    __m128i acc = _mm_setzero_si128();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        auto first = reinterpret_cast<const __m128i*>(values.data());
+        const auto last = reinterpret_cast<const __m128i*>(values.data() + values.size());
+        while (first < last) {
+            const auto v0 = _mm_loadu_si128(first++);
+            const auto v1 = _mm_loadu_si128(first++);
+            const auto v2 = _mm_loadu_si128(first++);
+            const auto v3 = _mm_loadu_si128(first++);
+            const auto tmp0 = _mm_or_si128(acc, v0);
+            const auto tmp1 = _mm_or_si128(v1, v2);
+            const auto tmp2 = _mm_or_si128(tmp0, tmp1);
+            acc = _mm_or_si128(tmp2, v3);
+        }
+    }
+    return _mm_cvtsi128_si64(acc);
+}
+
+
+TARGET("avx2") int64_t ReadBlockAvx2(std::span<const int64_t> values, size_t reps) {
+    __m256i acc = _mm256_setzero_si256();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        auto first = reinterpret_cast<const __m256i*>(values.data());
+        const auto last = reinterpret_cast<const __m256i*>(values.data() + values.size());
+        while (first < last) {
+            const auto v0 = _mm256_loadu_si256(first++);
+            const auto v1 = _mm256_loadu_si256(first++);
+            const auto v2 = _mm256_loadu_si256(first++);
+            const auto v3 = _mm256_loadu_si256(first++);
+            const auto tmp0 = _mm256_or_si256(acc, v0);
+            const auto tmp1 = _mm256_or_si256(v1, v2);
+            const auto tmp2 = _mm256_or_si256(tmp0, tmp1);
+            acc = _mm256_or_si256(tmp2, v3);
+        }
+    }
+    return _mm_cvtsi128_si64(_mm256_castsi256_si128(acc));
+}
+
 
-std::vector<size_t> GetBlockSizes(size_t maxSize) {
-    std::vector<size_t> blockSizes;
-    for (size_t s = 128; s <= maxSize; s *= 2) {
-        blockSizes.push_back(s);
-        if (s != maxSize) {
-            blockSizes.push_back(s * 5 / 4);
-            blockSizes.push_back(s * 6 / 4);
-            blockSizes.push_back(s * 7 / 4);
+TARGET("avx512f") int64_t ReadBlockAvx512(std::span<const int64_t> values, size_t reps) {
+    __m512i acc = _mm512_setzero_si512();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        auto first = reinterpret_cast<const __m512i*>(values.data());
+        const auto last = reinterpret_cast<const __m512i*>(values.data() + values.size());
+        while (first < last) {
+            const auto v0 = _mm512_loadu_si512(first++);
+            const auto v1 = _mm512_loadu_si512(first++);
+            const auto v2 = _mm512_loadu_si512(first++);
+            const auto v3 = _mm512_loadu_si512(first++);
+            const auto tmp0 = _mm512_or_si512(acc, v0);
+            const auto tmp1 = _mm512_or_si512(v1, v2);
+            const auto tmp2 = _mm512_or_si512(tmp0, tmp1);
+            acc = _mm512_or_si512(tmp2, v3);
         }
     }
-    return blockSizes;
+    int64_t lanes[8];
+    _mm512_storeu_si512(lanes, acc);
+    return lanes[0];
+}
+
+
+enum class Isa {
+    Sse2,
+    Avx2,
+    Avx512,
+};
+
+
+bool IsSupported(Isa isa) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+    __cpuid(info, 1);
+    const bool sse2 = (info[3] >> 26) & 1;
+    const bool osxsave = (info[2] >> 27) & 1;
+    if (isa == Isa::Sse2) {
+        return sse2;
+    }
+    if (!osxsave || maxLeaf < 7) {
+        return false;
+    }
+    // The OS must save the vector registers on context switches (XCR0).
+    const auto xcr0 = _xgetbv(0);
+    __cpuidex(info, 7, 0);
+    switch (isa) {
+        case Isa::Avx2: return (xcr0 & 0x06) == 0x06 && ((info[1] >> 5) & 1);
+        case Isa::Avx512: return (xcr0 & 0xE6) == 0xE6 && ((info[1] >> 16) & 1);
+        default: return false;
+    }
+#else
+    // Checks both CPUID and OS support of the register state.
+    __builtin_cpu_init();
+    switch (isa) {
+        case Isa::Sse2: return __builtin_cpu_supports("sse2");
+        case Isa::Avx2: return __builtin_cpu_supports("avx2");
+        case Isa::Avx512: return __builtin_cpu_supports("avx512f");
+        default: return false;
+    }
+#endif
 }
 
 
+struct IsaKernel {
+    Isa isa;
+    const char* name;
+    size_t vectorSize;
+    ReadKernel kernel;
+};
+
+
 int main() {
     using std::chrono::high_resolution_clock;
     using std::chrono::milliseconds;
     using std::chrono::nanoseconds;
 
-    constexpr size_t burstSize = 8;
     constexpr size_t maxBlockSize = 512 * 1048576;
 
-    for (auto blockSize : GetBlockSizes(maxBlockSize)) {
-        std::vector<int64_t> values(blockSize / sizeof(int64_t), 1);
-
-        size_t result = 0;
-        __m256i acc = _mm256_setzero_si256();
-        const size_t reps = 10 * maxBlockSize / blockSize;
-
-        const auto start = high_resolution_clock::now();
-        for (size_t rep = 0; rep < reps; ++rep) {
-            const auto step = 4 * sizeof(__m256i) / sizeof(int64_t);
-            auto first = reinterpret_cast<const __m256i*>(values.data());
-            const auto last = reinterpret_cast<const __m256i*>(values.data() + values.size() / step * step);
-            result += sizeof(__m256i) * (last - first);
-            while (first < last) {
-                const auto v0 = _mm256_loadu_si256(first++);
-                const auto v1 = _mm256_loadu_si256(first++);
-                const auto v2 = _mm256_loadu_si256(first++);
-                const auto v3 = _mm256_loadu_si256(first++);
-                const auto tmp0 = _mm256_or_si256(acc, v0);
-                const auto tmp1 = _mm256_or_si256(v1, v2);
-                const auto tmp2 = _mm256_or_si256(tmp0, tmp1);
-                acc = _mm256_or_si256(tmp2, v3);
-            }
-        }
-        const auto end = high_resolution_clock::now();
+    const IsaKernel kernels[] = {
+        { Isa::Sse2, "SSE2", sizeof(__m128i), ReadBlockSse2 },
+        { Isa::Avx2, "AVX2", sizeof(__m256i), ReadBlockAvx2 },
+        { Isa::Avx512, "AVX-512", sizeof(__m512i), ReadBlockAvx512 },
+    };
+
+    // Aligned, so that no vector load splits a cache line.
+    constexpr size_t alignment = 4096;
+    std::unique_ptr<int64_t, void (*)(void*)> data{
+        static_cast<int64_t*>(::operator new[](maxBlockSize, std::align_val_t{ alignment })),
+        [](void* ptr) { ::operator delete[](ptr, std::align_val_t{ alignment }); }
+    };
+    std::fill_n(data.get(), maxBlockSize / sizeof(int64_t), 1);
 
-        if (_mm256_extract_epi64(acc, 0) != 1) {
-            throw std::logic_error("incorrect result");
+    const auto cacheSizes = GetDataCacheSizes();
+    // Core cycles from the perf counter, which follow turbo and power saving
+    // states. Without it, ticks of the time stamp counter, which runs at the
+    // nominal frequency.
+    const bool coreCycles = perf_counters::instance().available(perf_event::cycles);
+    const char* cycleUnit = coreCycles ? "cycle" : "TSC tick";
+    // Peak bytes per cycle for each ISA and memory level, in order of appearance.
+    std::vector<std::string> levels;
+    std::map<std::string, std::map<std::string, double>> peakBytesPerCycle;
+
+    for (const auto& [isa, name, vectorSize, kernel] : kernels) {
+        if (!IsSupported(isa)) {
+            std::cout << name << ": not supported" << std::endl;
+            continue;
         }
+        std::cout << name << ":" << std::endl;
+
+        for (auto blockSize : GetBlockSizes(maxBlockSize)) {
+            const auto step = 4 * vectorSize / sizeof(int64_t);
+            const size_t count = blockSize / sizeof(int64_t);
+            const auto block = std::span<const int64_t>(data.get(), count / step * step);
+            if (block.empty()) {
+                continue;
+            }
+
+            const size_t reps = 10 * maxBlockSize / blockSize;
+
+            high_resolution_clock::time_point start, end;
+            uint64_t startTicks, endTicks;
+            perf_counters::sample startSample, endSample;
+            int64_t acc;
+            {
+                perf_region region(std::string(name) + " block size = " + std::to_string(blockSize));
+                start = high_resolution_clock::now();
+                startSample = perf_counters::instance().read();
+                startTicks = __rdtsc();
+                acc = kernel(block, reps);
+                endTicks = __rdtsc();
+                endSample = perf_counters::instance().read();
+                end = high_resolution_clock::now();
+            }
+
+            if (acc != 1) {
+                throw std::logic_error("incorrect result");
+            }
 
-        const auto time = duration_cast<nanoseconds>(end - start);
-        const auto bandwidth = result / float(time.count());
+            const size_t result = reps * block.size_bytes();
+            const auto time = duration_cast<nanoseconds>(end - start);
+            const auto bandwidth = result / float(time.count());
+            const auto cycles = perf_counters::difference(startSample, endSample)[size_t(perf_event::cycles)];
+            const auto bytesPerCycle = result / (coreCycles && cycles ? *cycles : double(endTicks - startTicks));
 
-        std::cout << "  block size = " << blockSize << ":    "
-                  << duration_cast<milliseconds>(time).count() << " ms, "
-                  << bandwidth << " GB/s" << std::endl;
+            const auto level = GetMemoryLevel(blockSize, cacheSizes);
+            if (std::ranges::find(levels, level) == levels.end()) {
+                levels.push_back(level);
+            }
+            auto& peak = peakBytesPerCycle[level][name];
+            peak = std::max(peak, bytesPerCycle);
+
+            std::cout << "  block size = " << blockSize << " (" << level << "):    "
+                      << duration_cast<milliseconds>(time).count() << " ms, "
+                      << bandwidth << " GB/s, "
+                      << bytesPerCycle << " B/" << cycleUnit << std::endl;
+        }
     }
-}
\ No newline at end of file
+
+    std::cout << "peak bytes per " << cycleUnit << ":" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const auto& level : levels) {
+        std::cout << "  " << level << ":";
+        for (const auto& [isa, name, vectorSize, kernel] : kernels) {
+            if (peakBytesPerCycle[level].contains(name)) {
+                std::cout << "    " << name << " " << peakBytesPerCycle[level][name];
+            }
+        }
+        std::cout << std::endl;
+    }
+}
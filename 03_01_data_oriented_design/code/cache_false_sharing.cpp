@@ -1,9 +1,18 @@
+#include "per_thread.hpp"
+#include "perf_counters.hpp"
+#include "reduce.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+
 #include <algorithm>
 #include <chrono>
+#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <new>
 #include <numeric>
 #include <span>
+#include <string>
 #include <thread>
 #include <vector>
 
@@ -14,20 +23,6 @@
 #endif
 
 
-std::vector<std::span<const int64_t>> partition_values(std::span<const int64_t> values, size_t nthreads) {
-    std::vector<std::span<const int64_t>> partitions;
-
-    const auto partition_size = (values.size() + nthreads - 1) / nthreads;
-    for (size_t thread_idx = 0; thread_idx < nthreads; ++thread_idx) {
-        const auto first = partition_size * thread_idx;
-        const auto last = std::min(values.size(), partition_size * (thread_idx + 1));
-        partitions.push_back(values.subspan(first, last - first));
-    }
-
-    return partitions;
-}
-
-
 NOINLINE void do_sum(volatile int64_t* out, std::span<const int64_t> values) {
     for (const auto& item : values) {
         const auto current = *out;
@@ -36,39 +31,52 @@ NOINLINE void do_sum(volatile int64_t* out, std::span<const int64_t> values) {
 }
 
 
-int64_t false_sharing(std::span<const int64_t> values, size_t nthreads) {
-    const auto partitions = partition_values(values, nthreads);
-    std::vector<int64_t> partition_sums(nthreads, 0);
+// The per-thread sums are packed next to each other, so up to 8 of them share
+// a cache line that bounces between the cores on every update.
+int64_t false_sharing(thread_pool& pool, std::span<const int64_t> values) {
+    per_thread<int64_t, alignof(int64_t)> partition_sums(pool.size(), 0);
 
-    std::vector<std::thread> threads;
+    pool.parallel_for({ 0, values.size() }, 1, [&](index_range part, size_t thread_idx) {
+        const auto partition = values.subspan(part.first, part.size());
+        do_sum(&partition_sums[thread_idx], partition);
+    });
+
+    return partition_sums.combine(std::plus{});
+}
 
-    for (size_t thread_idx = 0; thread_idx < nthreads; ++thread_idx) {
-        threads.push_back(std::thread([&partition_sums, &partitions, thread_idx] {
-            do_sum(&partition_sums[thread_idx], partitions[thread_idx]);
-        }));
-    }
 
-    std::ranges::for_each(threads, [](auto& th) { th.join(); });
-    return std::reduce(partition_sums.begin(), partition_sums.end(), 0LL);
+// Same as above, but every per-thread sum has a cache line for itself.
+int64_t padded_sharing(thread_pool& pool, std::span<const int64_t> values) {
+    per_thread<int64_t> partition_sums(pool.size(), 0);
+
+    pool.parallel_for({ 0, values.size() }, 1, [&](index_range part, size_t thread_idx) {
+        const auto partition = values.subspan(part.first, part.size());
+        do_sum(&partition_sums[thread_idx], partition);
+    });
+
+    return partition_sums.combine(std::plus{});
 }
 
 
-int64_t no_false_sharing(std::span<const int64_t> values, size_t nthreads) {
-    const auto partitions = partition_values(values, nthreads);
-    std::vector<int64_t> partition_sums(nthreads, 0);
+// Accumulate on the stack of each thread, only the final sum is shared.
+int64_t no_false_sharing(thread_pool& pool, std::span<const int64_t> values) {
+    per_thread<int64_t> partition_sums(pool.size(), 0);
 
-    std::vector<std::thread> threads;
+    pool.parallel_for({ 0, values.size() }, 1, [&](index_range part, size_t thread_idx) {
+        const auto partition = values.subspan(part.first, part.size());
+        int64_t local = 0;
+        do_sum(&local, partition);
+        partition_sums[thread_idx] = local;
+    });
+
+    return partition_sums.combine(std::plus{});
+}
 
-    for (size_t thread_idx = 0; thread_idx < nthreads; ++thread_idx) {
-        threads.push_back(std::thread([&partition_sums, &partitions, thread_idx] {
-            int64_t local = 0;
-            do_sum(&local, partitions[thread_idx]);
-            partition_sums[thread_idx] = local;
-        }));
-    }
 
-    std::ranges::for_each(threads, [](auto& th) { th.join(); });
-    return std::reduce(partition_sums.begin(), partition_sums.end(), 0LL);
+// Not about sharing: the vectorized reduce of reduce.hpp, which accumulates in
+// registers instead of through memory, for how much more that is worth.
+int64_t vectorized(thread_pool& pool, std::span<const int64_t> values) {
+    return reduce(values, int64_t(0), std::plus{}, { .pool = &pool });
 }
 
 
@@ -76,29 +84,31 @@ int main() {
     using std::chrono::high_resolution_clock;
     using std::chrono::milliseconds;
 
-    std::vector<int64_t> values(1'000'000'000, 1);
-    const size_t max_nthreads = std::min(size_t(std::thread::hardware_concurrency()), size_t(64) / sizeof(int64_t));
+    // Open the counters before any worker thread exists, so they count them too.
+    perf_counters::instance();
 
-    for (int nthreads = 1; nthreads <= max_nthreads; ++nthreads) {
+    std::vector<int64_t> values(1'000'000'000, 1);
+    const size_t max_nthreads = std::max(1u, std::thread::hardware_concurrency());
+
+    const auto measure = [&](const char* name, auto algorithm, thread_pool& pool) {
+        perf_region region(name);
+        const auto start = high_resolution_clock::now();
+        const auto result = algorithm(pool, values);
+        const auto end = high_resolution_clock::now();
+        std::cout << "  " << std::left << std::setw(18) << std::string(name) + ":"
+                  << duration_cast<milliseconds>(end - start).count() << " ms"
+                  << " (result=" << result << ")"
+                  << std::endl;
+    };
+
+    for (size_t nthreads = 1; nthreads <= max_nthreads; ++nthreads) {
+        thread_pool pool(nthreads);
         std::cout << "nthreads=" << nthreads << std::endl;
-        {
-            const auto start = high_resolution_clock::now();
-            const auto result = no_false_sharing(values, nthreads);
-            const auto end = high_resolution_clock::now();
-            std::cout << "  no false sharing: "
-                      << duration_cast<milliseconds>(end - start).count() << " ms"
-                      << " (result=" << result << ")"
-                      << std::endl;
-        }
-
-        {
-            const auto start = high_resolution_clock::now();
-            const auto result = false_sharing(values, nthreads);
-            const auto end = high_resolution_clock::now();
-            std::cout << "  false sharing:    "
-                      << duration_cast<milliseconds>(end - start).count() << " ms"
-                      << " (result=" << result << ")"
-                      << std::endl;
-        }
+        measure("no false sharing", no_false_sharing, pool);
+        measure("padded", padded_sharing, pool);
+        measure("false sharing", false_sharing, pool);
+        measure("reduce", vectorized, pool);
     }
-}
\ No newline at end of file
+
+    trace_write_chrome_json("03_01_cache_false_sharing.trace.json");
+}
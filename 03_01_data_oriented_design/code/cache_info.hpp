@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+    #include <unistd.h>
+#elif defined(_WIN32)
+    #include <windows.h>
+#endif
+
+
+// Block sizes for the cache probes: powers of two from 128 bytes with three
+// intermediate steps in between, so that cache capacity boundaries show up.
+inline std::vector<size_t> GetBlockSizes(size_t maxSize) {
+    std::vector<size_t> blockSizes;
+    for (size_t s = 128; s <= maxSize; s *= 2) {
+        blockSizes.push_back(s);
+        if (s != maxSize) {
+            blockSizes.push_back(s * 5 / 4);
+            blockSizes.push_back(s * 6 / 4);
+            blockSizes.push_back(s * 7 / 4);
+        }
+    }
+    return blockSizes;
+}
+
+
+// Sizes of the data caches in bytes, L1d first. Empty if the OS does not tell us.
+inline std::vector<size_t> GetDataCacheSizes() {
+    std::vector<size_t> sizes;
+#if defined(__linux__) && defined(_SC_LEVEL1_DCACHE_SIZE)
+    for (int name : { _SC_LEVEL1_DCACHE_SIZE, _SC_LEVEL2_CACHE_SIZE, _SC_LEVEL3_CACHE_SIZE }) {
+        const long size = sysconf(name);
+        if (size <= 0) {
+            break;
+        }
+        sizes.push_back(size_t(size));
+    }
+#elif defined(_WIN32)
+    DWORD length = 0;
+    GetLogicalProcessorInformation(nullptr, &length);
+    std::vector<SYSTEM_LOGICAL_PROCESSOR_INFORMATION> infos(length / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION));
+    if (GetLogicalProcessorInformation(infos.data(), &length)) {
+        for (const auto& info : infos) {
+            const auto& cache = info.Cache;
+            if (info.Relationship == RelationCache && cache.Type != CacheInstruction && cache.Level >= 1 && cache.Level <= 3) {
+                if (sizes.size() < cache.Level) {
+                    sizes.resize(cache.Level);
+                }
+                sizes[cache.Level - 1] = cache.Size;
+            }
+        }
+    }
+#endif
+    return sizes;
+}
+
+
+// Name of the smallest memory level a block of the given size fits into.
+inline std::string GetMemoryLevel(size_t blockSize, const std::vector<size_t>& cacheSizes) {
+    for (size_t level = 0; level < cacheSizes.size(); ++level) {
+        if (blockSize <= cacheSizes[level]) {
+            std::string name = "L";
+            name += std::to_string(level + 1);
+            return name;
+        }
+    }
+    return cacheSizes.empty() ? "?" : "DRAM";
+}
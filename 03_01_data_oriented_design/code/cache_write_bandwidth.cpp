@@ -0,0 +1,178 @@
+#include "cache_info.hpp"
+#include "perf_counters.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <immintrin.h>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+    #define NOINLINE __declspec(noinline)
+#else
+    #define NOINLINE __attribute__((noinline))
+#endif
+
+
+// Read only: the same OR-reduction as in cache_block_size.cpp, as a baseline.
+NOINLINE __m256i ReadBlock(std::span<const int64_t> block, __m256i acc) {
+    auto first = reinterpret_cast<const __m256i*>(block.data());
+    const auto last = reinterpret_cast<const __m256i*>(block.data() + block.size());
+    while (first < last) {
+        const auto v0 = _mm256_load_si256(first++);
+        const auto v1 = _mm256_load_si256(first++);
+        const auto v2 = _mm256_load_si256(first++);
+        const auto v3 = _mm256_load_si256(first++);
+        acc = _mm256_or_si256(_mm256_or_si256(acc, v0), _mm256_or_si256(_mm256_or_si256(v1, v2), v3));
+    }
+    return acc;
+}
+
+
+// Write only: regular stores. The cache line has to be read before it can be
+// partially overwritten (write-allocate), so the memory bus sees a read for
+// every line written, plus the write-back when the line is evicted.
+NOINLINE void WriteBlock(std::span<int64_t> block, __m256i value) {
+    auto first = reinterpret_cast<__m256i*>(block.data());
+    const auto last = reinterpret_cast<__m256i*>(block.data() + block.size());
+    while (first < last) {
+        _mm256_store_si256(first++, value);
+        _mm256_store_si256(first++, value);
+        _mm256_store_si256(first++, value);
+        _mm256_store_si256(first++, value);
+    }
+}
+
+
+// Read-modify-write: the read of the line is needed anyway, so there is no
+// extra allocate traffic compared to the program-visible loads and stores.
+NOINLINE void ReadModifyWriteBlock(std::span<int64_t> block, __m256i increment) {
+    auto first = reinterpret_cast<__m256i*>(block.data());
+    const auto last = reinterpret_cast<__m256i*>(block.data() + block.size());
+    while (first < last) {
+        const auto v0 = _mm256_load_si256(first + 0);
+        const auto v1 = _mm256_load_si256(first + 1);
+        const auto v2 = _mm256_load_si256(first + 2);
+        const auto v3 = _mm256_load_si256(first + 3);
+        _mm256_store_si256(first++, _mm256_add_epi64(v0, increment));
+        _mm256_store_si256(first++, _mm256_add_epi64(v1, increment));
+        _mm256_store_si256(first++, _mm256_add_epi64(v2, increment));
+        _mm256_store_si256(first++, _mm256_add_epi64(v3, increment));
+    }
+}
+
+
+// Write only with non-temporal stores: full lines are combined in write
+// buffers and sent to memory directly, without being read first. They also
+// bypass (and evict from) the caches, so they lose when the block would fit.
+NOINLINE void StreamBlock(std::span<int64_t> block, __m256i value) {
+    auto first = reinterpret_cast<__m256i*>(block.data());
+    const auto last = reinterpret_cast<__m256i*>(block.data() + block.size());
+    while (first < last) {
+        _mm256_stream_si256(first++, value);
+        _mm256_stream_si256(first++, value);
+        _mm256_stream_si256(first++, value);
+        _mm256_stream_si256(first++, value);
+    }
+    _mm_sfence();
+}
+
+
+template <class Kernel>
+double MeasureSeconds(const std::string& name, size_t reps, Kernel&& kernel) {
+    using std::chrono::high_resolution_clock;
+
+    kernel(); // Warm-up, brings the block into the caches if it fits.
+    perf_region region(name);
+    const auto start = high_resolution_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        kernel();
+    }
+    const auto end = high_resolution_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+
+struct LevelSummary {
+    double allocateAvoided = 0.0;
+    size_t count = 0;
+};
+
+
+int main() {
+    constexpr size_t maxBlockSize = 512 * 1048576;
+    constexpr size_t alignment = 4096;
+
+    std::unique_ptr<int64_t, void (*)(void*)> data{
+        static_cast<int64_t*>(::operator new[](maxBlockSize, std::align_val_t{ alignment })),
+        [](void* ptr) { ::operator delete[](ptr, std::align_val_t{ alignment }); }
+    };
+
+    const auto cacheSizes = GetDataCacheSizes();
+    std::map<std::string, LevelSummary> summaries;
+    std::vector<std::string> levels;
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "bandwidth in GB/s of program-visible traffic (read-modify-write counts both directions)" << std::endl;
+
+    for (auto blockSize : GetBlockSizes(maxBlockSize)) {
+        // Whole iterations of the 4x unrolled kernels only.
+        const size_t step = 4 * sizeof(__m256i) / sizeof(int64_t);
+        const size_t numValues = blockSize / sizeof(int64_t) / step * step;
+        const size_t bytes = numValues * sizeof(int64_t);
+        std::span<int64_t> block(data.get(), numValues);
+        const size_t reps = 10 * maxBlockSize / blockSize;
+        const auto ones = _mm256_set1_epi64x(1);
+        const auto zeros = _mm256_setzero_si256();
+
+        __m256i acc = zeros;
+        const auto name = " block size = " + std::to_string(blockSize);
+        const auto writeTime = MeasureSeconds("write" + name, reps, [&] { WriteBlock(block, zeros); });
+        const auto readTime = MeasureSeconds("read" + name, reps, [&] { acc = ReadBlock(block, acc); });
+        const auto rmwTime = MeasureSeconds("read-modify-write" + name, reps, [&] { ReadModifyWriteBlock(block, ones); });
+        const auto streamTime = MeasureSeconds("stream" + name, reps, [&] { StreamBlock(block, ones); });
+
+        if (_mm256_extract_epi64(acc, 0) != 0 || block.back() != 1) {
+            throw std::logic_error("incorrect result");
+        }
+
+        // If both kinds of store are limited by the same bus, regular stores
+        // move (writeTime / streamTime) bytes for every byte the streaming
+        // stores move. The excess is the write-allocate traffic that the
+        // non-temporal stores avoid. When the block fits into a cache, the
+        // streaming stores are slower, and nothing is avoided.
+        const double allocateAvoided = std::max(0.0, writeTime / streamTime - 1.0);
+
+        const auto level = GetMemoryLevel(blockSize, cacheSizes);
+        if (!summaries.contains(level)) {
+            levels.push_back(level);
+        }
+        summaries[level].allocateAvoided += allocateAvoided;
+        summaries[level].count += 1;
+
+        const auto bandwidth = [&](double seconds, size_t factor = 1) {
+            return factor * reps * bytes / seconds / 1e9;
+        };
+        std::cout << "  block size = " << blockSize << " (" << level << "):    "
+                  << "read " << bandwidth(readTime) << ", "
+                  << "write " << bandwidth(writeTime) << ", "
+                  << "read-modify-write " << bandwidth(rmwTime, 2) << ", "
+                  << "stream " << bandwidth(streamTime) << ", "
+                  << "write-allocate avoided " << 100.0 * allocateAvoided << "%"
+                  << std::endl;
+    }
+
+    std::cout << "write-allocate traffic avoided by streaming stores, in % of the bytes stored:" << std::endl;
+    for (const auto& level : levels) {
+        const auto& summary = summaries[level];
+        std::cout << "  " << level << ": " << 100.0 * summary.allocateAvoided / summary.count << "%" << std::endl;
+    }
+}
@@ -1,3 +1,5 @@
+#include "perf_counters.hpp"
+
 #include <algorithm>
 #include <array>
 #include <cassert>
@@ -9,6 +11,7 @@
 #include <numeric>
 #include <random>
 #include <span>
+#include <string>
 #include <vector>
 
 
@@ -79,13 +82,16 @@ int main() {
             size_t prefetchIdx = 0;
 
             const auto start = high_resolution_clock::now();
-            for (int i = 0; i < 1048576 * reps; ++i) {
-                const auto currentPtr = prefetch[prefetchIdx];
-                const auto prefetchedPtr = values.data() + burstSize * gen();
-                _mm_prefetch(reinterpret_cast<const char*>(prefetchedPtr), _MM_HINT_T0);
-                prefetch[prefetchIdx] = prefetchedPtr;
-                prefetchIdx = (prefetchIdx + 1) % prefetch.size();
-                result += *currentPtr;
+            {
+                perf_region region("block size = " + std::to_string(rowSize));
+                for (int i = 0; i < 1048576 * reps; ++i) {
+                    const auto currentPtr = prefetch[prefetchIdx];
+                    const auto prefetchedPtr = values.data() + burstSize * gen();
+                    _mm_prefetch(reinterpret_cast<const char*>(prefetchedPtr), _MM_HINT_T0);
+                    prefetch[prefetchIdx] = prefetchedPtr;
+                    prefetchIdx = (prefetchIdx + 1) % prefetch.size();
+                    result += *currentPtr;
+                }
             }
             const auto end = high_resolution_clock::now();
 
@@ -1,19 +1,15 @@
+#include "perf_counters.hpp"
+#include "reduce.hpp"
+
 #include <chrono>
 #include <iostream>
 #include <span>
 #include <vector>
 
 
-int64_t sum_all(std::span<int64_t> values) {
-    int64_t sum = 0;
-    for (size_t idx = 0; idx < (values.size() & ~7u); idx += 8) {
-        // Pairwise sum of all elements in a block of 8.
-        sum += ((values[idx + 0] + values[idx + 1])
-                + (values[idx + 2] + values[idx + 3]))
-               + ((values[idx + 4] + values[idx + 5])
-                  + (values[idx + 6] + values[idx + 7]));
-    }
-    return sum;
+int64_t sum_all(std::span<const int64_t> values) {
+    // Independent accumulators over all elements, combined pairwise.
+    return reduce(values, int64_t(0));
 }
 
 int64_t sum_every_8th(std::span<int64_t> values) {
@@ -39,17 +35,23 @@ int main() {
     std::vector<int64_t> values(num_values, 1);
 
     const auto t1 = high_resolution_clock::now();
-    for (int i = 0; i < reps; ++i) {
-        const auto result = sum_all(values);
-        if (result != num_values) {
-            throw std::logic_error("incorect result");
+    {
+        perf_region region("sum all");
+        for (int i = 0; i < reps; ++i) {
+            const auto result = sum_all(values);
+            if (result != num_values) {
+                throw std::logic_error("incorect result");
+            }
         }
     }
     const auto t2 = high_resolution_clock::now();
-    for (int i = 0; i < reps; ++i) {
-        const auto result = sum_every_8th(values);
-        if (result != num_values / 8) {
-            throw std::logic_error("incorect result");
+    {
+        perf_region region("sum every 8th");
+        for (int i = 0; i < reps; ++i) {
+            const auto result = sum_every_8th(values);
+            if (result != num_values / 8) {
+                throw std::logic_error("incorect result");
+            }
         }
     }
     const auto t3 = high_resolution_clock::now();
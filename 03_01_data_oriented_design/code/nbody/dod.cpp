@@ -1,4 +1,5 @@
 #include "dod.hpp"
+#include "../trace.hpp"
 
 #include <cmath>
 
@@ -11,12 +12,13 @@ float Distance(float x1, float y1, float z1, float x2, float y2, float z2) {
 }
 
 
-Vec3s GetForces(const Vec3s& positions, const std::vector<float>& masses) {
+Vec3s GetForces(const Vec3s& positions, const std::pmr::vector<float>& masses, std::pmr::memory_resource* scratch) {
+    TRACE_SCOPE("GetForces");
     const size_t n = masses.size();
     Vec3s forces{
-        std::vector<float>(n, 0.0f),
-        std::vector<float>(n, 0.0f),
-        std::vector<float>(n, 0.0f),
+        std::pmr::vector<float>(n, 0.0f, scratch),
+        std::pmr::vector<float>(n, 0.0f, scratch),
+        std::pmr::vector<float>(n, 0.0f, scratch),
     };
 
     for (size_t anchorIdx = 0; anchorIdx < n; ++anchorIdx) {
@@ -51,12 +53,14 @@ Vec3s GetForces(const Vec3s& positions, const std::vector<float>& masses) {
 }
 
 
-Vec3s GetAccelerations(const Vec3s& forces, const std::vector<float>& masses) {
+Vec3s GetAccelerations(const Vec3s& forces, const std::pmr::vector<float>& masses, std::pmr::memory_resource* scratch) {
+    TRACE_SCOPE("GetAccelerations");
     const auto n = masses.size();
-    Vec3s accelerations;
-    accelerations.xs.resize(n);
-    accelerations.ys.resize(n);
-    accelerations.zs.resize(n);
+    Vec3s accelerations{
+        std::pmr::vector<float>(n, scratch),
+        std::pmr::vector<float>(n, scratch),
+        std::pmr::vector<float>(n, scratch),
+    };
     for (size_t i = 0; i < n; ++i) {
         const auto mass = masses[i];
         accelerations.xs[i] = forces.xs[i] * mass;
@@ -67,12 +71,14 @@ Vec3s GetAccelerations(const Vec3s& forces, const std::vector<float>& masses) {
 }
 
 
-Vec3s IntegrateVec3s(const Vec3s& quantity, const Vec3s& derivative, float deltaTime) {
+Vec3s IntegrateVec3s(const Vec3s& quantity, const Vec3s& derivative, float deltaTime, std::pmr::memory_resource* scratch) {
+    TRACE_SCOPE("IntegrateVec3s");
     const auto n = quantity.xs.size();
-    Vec3s newQuantity;
-    newQuantity.xs.resize(n);
-    newQuantity.ys.resize(n);
-    newQuantity.zs.resize(n);
+    Vec3s newQuantity{
+        std::pmr::vector<float>(n, scratch),
+        std::pmr::vector<float>(n, scratch),
+        std::pmr::vector<float>(n, scratch),
+    };
     for (size_t i = 0; i < n; ++i) {
         newQuantity.xs[i] = Integrate(quantity.xs[i], derivative.xs[i], deltaTime);
         newQuantity.ys[i] = Integrate(quantity.ys[i], derivative.ys[i], deltaTime);
@@ -82,11 +88,14 @@ Vec3s IntegrateVec3s(const Vec3s& quantity, const Vec3s& derivative, float delta
 }
 
 
-void SimulationDod::Update(float deltaTime) {
-    const auto forces = GetForces(m_bodies.positions, m_bodies.masses);
-    const auto accelerations = GetAccelerations(forces, m_bodies.masses);
-    auto velocities = IntegrateVec3s(m_bodies.velocities, accelerations, deltaTime);
-    auto positions = IntegrateVec3s(m_bodies.positions, velocities, deltaTime);
+void SimulationDod::Update(float deltaTime, std::pmr::memory_resource* scratch) {
+    TRACE_SCOPE("SimulationDod::Update");
+    const auto forces = GetForces(m_bodies.positions, m_bodies.masses, scratch);
+    const auto accelerations = GetAccelerations(forces, m_bodies.masses, scratch);
+    auto velocities = IntegrateVec3s(m_bodies.velocities, accelerations, deltaTime, scratch);
+    auto positions = IntegrateVec3s(m_bodies.positions, velocities, deltaTime, scratch);
+    // If scratch is not the resource of the bodies, these copy the elements
+    // instead of moving the buffers, so the bodies never point into scratch.
     m_bodies.positions = std::move(positions);
     m_bodies.velocities = std::move(velocities);
 }
@@ -2,21 +2,24 @@
 
 #include "common.hpp"
 
+#include <memory_resource>
 #include <utility>
 #include <vector>
 
 
+// The vectors take a memory resource, so that the temporaries of a time
+// step can live in scratch memory.
 struct Vec3s {
-    std::vector<float> xs;
-    std::vector<float> ys;
-    std::vector<float> zs;
+    std::pmr::vector<float> xs;
+    std::pmr::vector<float> ys;
+    std::pmr::vector<float> zs;
 };
 
 
 struct Bodies {
     Vec3s positions;
     Vec3s velocities;
-    std::vector<float> masses;
+    std::pmr::vector<float> masses;
 };
 
 
@@ -24,7 +27,8 @@ class SimulationDod {
 public:
     SimulationDod(Bodies bodies) : m_bodies(std::move(bodies)) {}
 
-    void Update(float deltaTime);
+    // Temporaries of the time step are allocated from scratch.
+    void Update(float deltaTime, std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
     const Bodies& GetBodies() const { return m_bodies; }
 
 private:
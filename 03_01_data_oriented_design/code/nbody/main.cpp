@@ -1,17 +1,22 @@
 #include "dod.hpp"
+#include "memory_resources.hpp"
 #include "oop.hpp"
+#include "../perf_counters.hpp"
+#include "../trace.hpp"
 
 #include <algorithm>
 #include <chrono>
 #include <functional>
 #include <iostream>
+#include <memory_resource>
 #include <numeric>
 #include <random>
+#include <string>
 
 
 template <class Rng, class Rne>
-std::vector<float> RandomVector(size_t size, Rng&& rng, Rne&& rne) {
-    std::vector<float> v(size);
+std::pmr::vector<float> RandomVector(size_t size, Rng&& rng, Rne&& rne) {
+    std::pmr::vector<float> v(size);
     std::ranges::generate(v, [&] { return rng(rne); });
     return v;
 }
@@ -71,6 +76,41 @@ void PrintBodies(const std::vector<Body>& bodies) {
 }
 
 
+// Runs a copy of the simulation with the temporaries of every time step on
+// the heap, and one with them in a frame arena that is reset after every
+// time step. Both count the allocations that reach the heap.
+template <class Simulation>
+void MeasureScratch(const std::string& name, const Simulation& initial, size_t numTimesteps, float deltaTime) {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::microseconds;
+
+    counting_resource heap;
+    Simulation onHeap = initial;
+    const auto heapStart = high_resolution_clock::now();
+    for (size_t timestep = 0; timestep < numTimesteps; ++timestep) {
+        onHeap.Update(deltaTime, &heap);
+    }
+    const auto heapEnd = high_resolution_clock::now();
+
+    counting_resource arenaUpstream;
+    frame_arena frame(64 * 1024, &arenaUpstream);
+    Simulation inArena = initial;
+    const auto arenaStart = high_resolution_clock::now();
+    for (size_t timestep = 0; timestep < numTimesteps; ++timestep) {
+        inArena.Update(deltaTime, &frame);
+        frame.reset();
+    }
+    const auto arenaEnd = high_resolution_clock::now();
+
+    std::cout << name << " scratch: "
+              << "heap " << heap.allocations() << " allocations, "
+              << duration_cast<microseconds>(heapEnd - heapStart).count() << " us; "
+              << "frame arena " << arenaUpstream.allocations() << " allocations, "
+              << duration_cast<microseconds>(arenaEnd - arenaStart).count() << " us"
+              << std::endl;
+}
+
+
 int main() {
     using std::chrono::high_resolution_clock;
     using std::chrono::milliseconds;
@@ -86,6 +126,7 @@ int main() {
     SimulationOop simOop{ oopBodies };
 
     {
+        perf_region region("OOP");
         const auto start = high_resolution_clock::now();
         for (size_t timestep = 0; timestep < numTimesteps; ++timestep) {
             simOop.Update(deltaTime);
@@ -96,6 +137,7 @@ int main() {
     }
 
     {
+        perf_region region("DoD");
         const auto start = high_resolution_clock::now();
         for (size_t timestep = 0; timestep < numTimesteps; ++timestep) {
             simDod.Update(deltaTime);
@@ -119,4 +161,11 @@ int main() {
     else {
         std::cout << "Two simulations DO NOT match!" << std::endl;
     }
+
+    // With few bodies, allocating the temporaries is a big part of a time step.
+    const auto fewBodies = RandomBodies(16);
+    MeasureScratch("OOP", SimulationOop{ ConvertBodies(fewBodies) }, 100000, deltaTime);
+    MeasureScratch("DoD", SimulationDod{ fewBodies }, 100000, deltaTime);
+
+    trace_write_chrome_json("03_01_nbody.trace.json");
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "oop.hpp"
+#include "../trace.hpp"
 
 #include <cmath>
 #include <ranges>
@@ -55,8 +56,9 @@ void Body::Update(float deltaTime, const Vec3& force) {
 }
 
 
-void SimulationOop::Update(float deltaTime) {
-    std::vector<Vec3> forces(m_bodies.size(), Vec3{ 0, 0, 0 });
+void SimulationOop::Update(float deltaTime, std::pmr::memory_resource* scratch) {
+    TRACE_SCOPE("SimulationOop::Update");
+    std::pmr::vector<Vec3> forces(m_bodies.size(), Vec3{ 0, 0, 0 }, scratch);
 
     const auto n = m_bodies.size();
     for (size_t i = 0; i < n; ++i) {
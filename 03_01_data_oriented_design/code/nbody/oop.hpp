@@ -2,6 +2,7 @@
 
 #include "common.hpp"
 
+#include <memory_resource>
 #include <utility>
 #include <vector>
 
@@ -39,7 +40,8 @@ class SimulationOop {
 public:
     SimulationOop(std::vector<Body> bodies) : m_bodies(std::move(bodies)) {}
 
-    void Update(float deltaTime);
+    // Temporaries of the time step are allocated from scratch.
+    void Update(float deltaTime, std::pmr::memory_resource* scratch = std::pmr::get_default_resource());
     const std::vector<Body>& GetBodies() const { return m_bodies; }
 
 private:
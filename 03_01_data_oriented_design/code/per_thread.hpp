@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+
+#ifdef __cpp_lib_hardware_interference_size
+    #if defined(__GNUC__) && !defined(__clang__)
+        // GCC warns that the value depends on -mtune, which is what we want.
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Winterference-size"
+    #endif
+inline constexpr size_t cache_line_size = std::hardware_destructive_interference_size;
+    #if defined(__GNUC__) && !defined(__clang__)
+        #pragma GCC diagnostic pop
+    #endif
+#else
+inline constexpr size_t cache_line_size = 64;
+#endif
+
+
+// One value of T per thread, each in its own cache line(s), so that threads
+// can update their own slot without invalidating the cache lines of others.
+// Passing alignof(T) as the alignment packs the slots densely instead, which
+// is only useful to demonstrate false sharing.
+template <class T, size_t Alignment = cache_line_size>
+class per_thread {
+    struct alignas(std::max(Alignment, alignof(T))) slot {
+        T value;
+    };
+
+public:
+    explicit per_thread(size_t nthreads, const T& init = T{}) : m_slots(nthreads, slot{ init }) {}
+
+    T& operator[](size_t thread_idx) { return m_slots[thread_idx].value; }
+    const T& operator[](size_t thread_idx) const { return m_slots[thread_idx].value; }
+    size_t size() const { return m_slots.size(); }
+
+    // Reduce the values of all threads with a binary operation, like
+    // tbb::combinable::combine. Call only once the threads are done, and
+    // only with at least one thread.
+    template <class BinaryOp>
+    T combine(BinaryOp op) const {
+        assert(!m_slots.empty());
+        T result = m_slots.front().value;
+        for (size_t thread_idx = 1; thread_idx < m_slots.size(); ++thread_idx) {
+            result = op(std::move(result), m_slots[thread_idx].value);
+        }
+        return result;
+    }
+
+    // Visit the value of every thread, like tbb::combinable::combine_each.
+    template <class Fun>
+    void combine_each(Fun fun) const {
+        for (const auto& slot : m_slots) {
+            fun(slot.value);
+        }
+    }
+
+private:
+    std::vector<slot> m_slots;
+};
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+
+// Hardware performance counters through Linux perf_event_open.
+//
+// Counters that cannot be opened (not Linux, perf_event_paranoid too high,
+// no PMU in a virtual machine, ...) are simply missing from the report, so
+// every program still runs and still reports wall time.
+//
+// Counters are opened with inherit, so they also count threads that are
+// created after the counters are opened. Call perf_counters::instance()
+// at the start of main() in multithreaded programs.
+
+
+enum class perf_event {
+    cycles,
+    instructions,
+    llc_misses,
+    dtlb_misses,
+    branch_misses,
+};
+
+inline constexpr size_t perf_event_count = 5;
+
+
+class perf_counters {
+public:
+    // Raw counter value, together with the times the counter was enabled and
+    // actually counting. The two differ if the kernel multiplexes counters.
+    struct reading {
+        uint64_t value = 0;
+        uint64_t enabled = 0;
+        uint64_t running = 0;
+    };
+
+    using sample = std::array<std::optional<reading>, perf_event_count>;
+
+    static perf_counters& instance() {
+        static perf_counters counters;
+        return counters;
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    ~perf_counters() {
+#if defined(__linux__)
+        for (int fd : m_fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+#endif
+    }
+
+    bool available(perf_event event) const { return m_fds[size_t(event)] >= 0; }
+
+    sample read() const {
+        sample result;
+#if defined(__linux__)
+        for (size_t idx = 0; idx < perf_event_count; ++idx) {
+            reading r;
+            if (m_fds[idx] >= 0 && ::read(m_fds[idx], &r, sizeof(r)) == sizeof(r)) {
+                result[idx] = r;
+            }
+        }
+#endif
+        return result;
+    }
+
+    // Events counted between two samples, scaled up if the counter was only
+    // running for part of the time.
+    static std::array<std::optional<double>, perf_event_count> difference(const sample& start, const sample& end) {
+        std::array<std::optional<double>, perf_event_count> result;
+        for (size_t idx = 0; idx < perf_event_count; ++idx) {
+            if (start[idx] && end[idx]) {
+                const double value = double(end[idx]->value - start[idx]->value);
+                const auto enabled = end[idx]->enabled - start[idx]->enabled;
+                const auto running = end[idx]->running - start[idx]->running;
+                if (running > 0) {
+                    result[idx] = value * double(enabled) / double(running);
+                }
+                else if (enabled == 0) {
+                    result[idx] = value;
+                }
+            }
+        }
+        return result;
+    }
+
+private:
+    perf_counters() {
+        m_fds.fill(-1);
+#if defined(__linux__)
+        const auto cache_event = [](uint64_t cache) {
+            return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        const std::array<std::pair<uint32_t, uint64_t>, perf_event_count> configs = { {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL) },
+            { PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB) },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        } };
+
+        for (size_t idx = 0; idx < perf_event_count; ++idx) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = configs[idx].first;
+            attr.config = configs[idx].second;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            m_fds[idx] = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    std::array<int, perf_event_count> m_fds;
+};
+
+
+// Measures wall time and the hardware counters from construction to
+// destruction, and prints them as one line to std::cout, e.g.
+//
+//   [perf] sum all: 2093 ms, 8.1e+09 cycles, 1.2e+10 instructions (IPC 1.48),
+//          LLC misses 3.4e+07 (2.8 MPKI), dTLB misses 1.0e+04 (0.0 MPKI), ...
+//
+// Misses are also given per thousand instructions (MPKI) when available.
+class perf_region {
+public:
+    explicit perf_region(std::string name) : m_name(std::move(name)) {
+        m_start_sample = perf_counters::instance().read();
+        m_start_time = std::chrono::high_resolution_clock::now();
+    }
+
+    perf_region(const perf_region&) = delete;
+    perf_region& operator=(const perf_region&) = delete;
+
+    ~perf_region() {
+        const auto end_time = std::chrono::high_resolution_clock::now();
+        const auto end_sample = perf_counters::instance().read();
+        std::cout << format(m_name, end_time - m_start_time, perf_counters::difference(m_start_sample, end_sample)) << std::endl;
+    }
+
+private:
+    static std::string format(const std::string& name,
+                              std::chrono::high_resolution_clock::duration time,
+                              const std::array<std::optional<double>, perf_event_count>& counts) {
+        const auto& cycles = counts[size_t(perf_event::cycles)];
+        const auto& instructions = counts[size_t(perf_event::instructions)];
+
+        std::ostringstream os;
+        os << std::setprecision(3);
+        os << "[perf] " << name << ": "
+           << std::chrono::duration_cast<std::chrono::milliseconds>(time).count() << " ms";
+        if (cycles) {
+            os << ", " << *cycles << " cycles";
+        }
+        if (instructions) {
+            os << ", " << *instructions << " instructions";
+            if (cycles && *cycles > 0) {
+                os << " (IPC " << *instructions / *cycles << ")";
+            }
+        }
+        const std::pair<perf_event, const char*> misses[] = {
+            { perf_event::llc_misses, "LLC misses" },
+            { perf_event::dtlb_misses, "dTLB misses" },
+            { perf_event::branch_misses, "branch misses" },
+        };
+        for (const auto& [event, label] : misses) {
+            if (const auto& count = counts[size_t(event)]) {
+                os << ", " << label << " " << *count;
+                if (instructions && *instructions > 0) {
+                    os << " (" << 1000.0 * *count / *instructions << " MPKI)";
+                }
+            }
+        }
+        if (std::ranges::none_of(counts, [](const auto& count) { return count.has_value(); })) {
+            os << " (hardware counters unavailable)";
+        }
+        return os.str();
+    }
+
+    std::string m_name;
+    perf_counters::sample m_start_sample;
+    std::chrono::high_resolution_clock::time_point m_start_time;
+};
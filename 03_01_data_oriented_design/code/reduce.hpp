@@ -0,0 +1,260 @@
+#pragma once
+
+#include "per_thread.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <stdexcept>
+#include <vector>
+
+
+// Reduction of a range (a vector, a span, but also views like iota | transform)
+// with an associative binary operation:
+//
+//   reduce(values, int64_t(0));                                        // sum
+//   reduce(values, 0.0, std::plus{}, { .method = summation::kahan });  // compensated sum
+//   reduce(values, int64_t(0), std::plus{}, { .pool = &pool });        // on all threads of the pool
+//
+// Like std::reduce, the elements are combined in a different order than a
+// plain loop, but the order is always the same for a given number of threads:
+//
+// - Each thread keeps several independent accumulators (lanes), so the
+//   additions do not wait on each other and the compiler can keep the lanes
+//   in SIMD registers. For floats the lanes are explicit, so this does not
+//   require -ffast-math.
+// - The lanes, and then the results of the threads, are combined pairwise
+//   in a tree. The threads combine their results in parallel, which pays
+//   off for expensive operations, e.g. adding up histograms.
+//
+// Only random-access ranges of known size are split over threads. Other
+// ranges are copied into a buffer chunk by chunk on the calling thread.
+
+
+enum class summation {
+    plain,     // Lanes only.
+    pairwise,  // Recursive halving, the rounding error grows with log(n) instead of n.
+    kahan,     // Compensated summation, the rounding error does not grow with n.
+};
+
+
+struct reduce_policy {
+    thread_pool* pool = nullptr;          // Reduce on the calling thread only if null.
+    size_t grain = 4096;                  // Parts of the threads are multiples of grain elements.
+    summation method = summation::plain;  // Anything but plain requires a floating-point sum.
+};
+
+
+namespace reduce_detail {
+
+// One cache line of accumulators, but at least 8 of them.
+template <class T>
+inline constexpr size_t lanes = std::bit_floor(std::max(size_t(8), 64 / sizeof(T)));
+
+// Pairwise summation switches to the lanes below this size.
+inline constexpr size_t pairwise_block = 256;
+
+template <class T, class BinaryOp>
+inline constexpr bool is_float_sum = std::floating_point<T> && (std::same_as<BinaryOp, std::plus<>> || std::same_as<BinaryOp, std::plus<T>>);
+
+
+template <class T, size_t N, class BinaryOp>
+T combine_tree(std::array<T, N> acc, BinaryOp& op) {
+    for (size_t width = N / 2; width > 0; width /= 2) {
+        for (size_t lane = 0; lane < width; ++lane) {
+            acc[lane] = op(acc[lane], acc[lane + width]);
+        }
+    }
+    return acc[0];
+}
+
+
+// The reduce_* functions require count > 0.
+template <class T, class It, class BinaryOp>
+T reduce_lanes(It first, size_t count, BinaryOp& op) {
+    constexpr size_t n = lanes<T>;
+    if (count < n) {
+        T acc = first[0];
+        for (size_t idx = 1; idx < count; ++idx) {
+            acc = op(acc, first[idx]);
+        }
+        return acc;
+    }
+
+    std::array<T, n> acc;
+    for (size_t lane = 0; lane < n; ++lane) {
+        acc[lane] = first[lane];
+    }
+    size_t idx = n;
+    for (; idx + n <= count; idx += n) {
+        for (size_t lane = 0; lane < n; ++lane) {
+            acc[lane] = op(acc[lane], first[idx + lane]);
+        }
+    }
+    for (; idx < count; ++idx) {
+        acc[idx % n] = op(acc[idx % n], first[idx]);
+    }
+    return combine_tree(acc, op);
+}
+
+
+template <class T, class It>
+T reduce_pairwise(It first, size_t count) {
+    if (count <= pairwise_block) {
+        std::plus<> op;
+        return reduce_lanes<T>(first, count, op);
+    }
+    const size_t half = count / 2;
+    return reduce_pairwise<T>(first, half) + reduce_pairwise<T>(first + half, count - half);
+}
+
+
+// Adds value to sum, and keeps the part of value that was rounded off in
+// compensation. The sum is then actually sum - compensation.
+template <class T>
+void kahan_add(T& sum, T& compensation, T value) {
+    const T corrected = value - compensation;
+    const T next = sum + corrected;
+    compensation = (next - sum) - corrected;
+    sum = next;
+}
+
+
+template <class T, class It>
+T reduce_kahan(It first, size_t count) {
+    constexpr size_t n = lanes<T>;
+    std::array<T, n> sums{};
+    std::array<T, n> compensations{};
+    size_t idx = 0;
+    for (; idx + n <= count; idx += n) {
+        for (size_t lane = 0; lane < n; ++lane) {
+            kahan_add(sums[lane], compensations[lane], T(first[idx + lane]));
+        }
+    }
+    for (; idx < count; ++idx) {
+        kahan_add(sums[0], compensations[0], T(first[idx]));
+    }
+
+    T sum = 0;
+    T compensation = 0;
+    for (size_t lane = 0; lane < n; ++lane) {
+        kahan_add(sum, compensation, sums[lane] - compensations[lane]);
+    }
+    return sum - compensation;
+}
+
+
+template <class T, class It, class BinaryOp>
+T reduce_part(It first, size_t count, BinaryOp& op, summation method) {
+    if constexpr (is_float_sum<T, BinaryOp>) {
+        switch (method) {
+            case summation::pairwise: return reduce_pairwise<T>(first, count);
+            case summation::kahan: return reduce_kahan<T>(first, count);
+            case summation::plain: break;
+        }
+    }
+    return reduce_lanes<T>(first, count, op);
+}
+
+
+template <class Range>
+inline constexpr bool is_splittable = std::ranges::random_access_range<Range>
+                                      && std::sized_sentinel_for<std::ranges::sentinel_t<Range>, std::ranges::iterator_t<Range>>;
+
+
+template <class T, class Range, class BinaryOp>
+T reduce_chunked(Range&& values, T init, BinaryOp& op, summation method) {
+    constexpr size_t chunk_size = 1024;
+    std::array<T, chunk_size> chunk;
+    std::vector<T> partials;
+    size_t count = 0;
+    for (auto&& value : values) {
+        chunk[count++] = value;
+        if (count == chunk_size) {
+            partials.push_back(reduce_part<T>(chunk.begin(), count, op, method));
+            count = 0;
+        }
+    }
+    if (count > 0) {
+        partials.push_back(reduce_part<T>(chunk.begin(), count, op, method));
+    }
+    if (partials.empty()) {
+        return init;
+    }
+    return op(init, reduce_part<T>(partials.begin(), partials.size(), op, method));
+}
+
+
+template <class T, class Range, class BinaryOp>
+T reduce_split(Range&& values, T init, BinaryOp& op, const reduce_policy& policy) {
+    const size_t size = std::ranges::distance(values);
+    const auto first = std::ranges::begin(values);
+    if (size == 0) {
+        return init;
+    }
+    if (!policy.pool || policy.pool->size() == 1) {
+        return op(init, reduce_part<T>(first, size, op, policy.method));
+    }
+
+    const size_t nthreads = policy.pool->size();
+    per_thread<std::optional<T>> partials(nthreads);
+    std::barrier sync{ std::ptrdiff_t(nthreads) };
+
+    policy.pool->run_on_all([&](size_t thread_idx) {
+        try {
+            const auto part = static_partition({ 0, size }, thread_idx, nthreads, policy.grain);
+            if (!part.empty()) {
+                partials[thread_idx] = reduce_part<T>(first + part.first, part.size(), op, policy.method);
+            }
+
+            // In every round, the threads at multiples of 2 * stride absorb the
+            // result of the thread stride to their right.
+            for (size_t stride = 1; stride < nthreads; stride *= 2) {
+                sync.arrive_and_wait();
+                if (thread_idx % (2 * stride) == 0 && thread_idx + stride < nthreads) {
+                    auto& mine = partials[thread_idx];
+                    const auto& theirs = partials[thread_idx + stride];
+                    if (mine && theirs) {
+                        mine = op(*mine, *theirs);
+                    }
+                    else if (theirs) {
+                        mine = theirs;
+                    }
+                }
+            }
+        }
+        catch (...) {
+            // Do not let the other threads wait for this one.
+            sync.arrive_and_drop();
+            throw;
+        }
+    });
+
+    return op(init, *partials[0]);
+}
+
+} // namespace reduce_detail
+
+
+template <std::ranges::input_range Range, class T, class BinaryOp = std::plus<>>
+T reduce(Range&& values, T init, BinaryOp op = {}, const reduce_policy& policy = {}) {
+    using namespace reduce_detail;
+
+    if (policy.method != summation::plain && !is_float_sum<T, BinaryOp>) {
+        throw std::invalid_argument("pairwise and Kahan summation require a floating-point sum");
+    }
+    if constexpr (is_splittable<Range>) {
+        return reduce_split(values, init, op, policy);
+    }
+    else {
+        return reduce_chunked(values, init, op, policy.method);
+    }
+}
@@ -0,0 +1,150 @@
+#include "perf_counters.hpp"
+#include "reduce.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+    #define NOINLINE __declspec(noinline)
+#else
+    #define NOINLINE __attribute__((noinline))
+#endif
+
+
+// One accumulator: every addition waits for the previous one.
+template <class T>
+NOINLINE T sum_loop(std::span<const T> values) {
+    T sum = 0;
+    for (const auto& value : values) {
+        sum += value;
+    }
+    return sum;
+}
+
+
+// The former sum_all of dram_burst_mode.cpp, unrolled by hand.
+NOINLINE int64_t sum_unrolled(std::span<const int64_t> values) {
+    int64_t sum = 0;
+    for (size_t idx = 0; idx < (values.size() & ~7u); idx += 8) {
+        sum += ((values[idx + 0] + values[idx + 1])
+                + (values[idx + 2] + values[idx + 3]))
+               + ((values[idx + 4] + values[idx + 5])
+                  + (values[idx + 6] + values[idx + 7]));
+    }
+    return sum;
+}
+
+
+template <class T>
+NOINLINE T sum_reduce(std::span<const T> values, const reduce_policy& policy) {
+    return reduce(values, T(0), std::plus{}, policy);
+}
+
+
+// Prints the time per call, and returns the result for checking.
+template <class Algorithm>
+auto Measure(const std::string& name, size_t reps, Algorithm&& algorithm) {
+    using std::chrono::high_resolution_clock;
+
+    auto result = algorithm();
+    const auto start = high_resolution_clock::now();
+    {
+        perf_region region(name);
+        for (size_t rep = 0; rep < reps; ++rep) {
+            result = algorithm();
+        }
+    }
+    const auto end = high_resolution_clock::now();
+    std::cout << "  " << std::left << std::setw(28) << name + ":"
+              << std::chrono::duration<double, std::milli>(end - start).count() / reps << " ms";
+    return result;
+}
+
+
+int main() {
+    // Open the counters before any worker thread exists, so they count them too.
+    perf_counters::instance();
+
+    constexpr size_t num_values = 32 * 1024 * 1024;
+    constexpr size_t reps = 10;
+    const size_t max_nthreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "int64_t, " << num_values << " values" << std::endl;
+    {
+        const std::vector<int64_t> values(num_values, 1);
+        const auto check = [&](int64_t result) {
+            if (result != int64_t(num_values)) {
+                throw std::logic_error("incorrect result");
+            }
+            std::cout << std::endl;
+        };
+
+        check(Measure("loop", reps, [&] { return sum_loop<int64_t>(values); }));
+        check(Measure("unrolled", reps, [&] { return sum_unrolled(values); }));
+        check(Measure("reduce", reps, [&] { return sum_reduce<int64_t>(values, {}); }));
+        for (size_t nthreads = 2; nthreads <= max_nthreads; nthreads *= 2) {
+            thread_pool pool(nthreads);
+            const auto name = "reduce, " + std::to_string(nthreads) + " threads";
+            check(Measure(name, reps, [&] { return sum_reduce<int64_t>(values, { .pool = &pool }); }));
+        }
+    }
+
+    // The exact sum is 0.1 * num_values: a float accumulator stops growing
+    // long before that, independent ones lose less, Kahan nothing.
+    std::cout << "float, " << num_values << " values" << std::endl;
+    {
+        const std::vector<float> values(num_values, 0.1f);
+        const double exact = double(0.1f) * num_values;
+        const auto check = [&](float result) {
+            std::cout << ", relative error " << std::abs(result - exact) / exact << std::endl;
+        };
+
+        check(Measure("loop", reps, [&] { return sum_loop<float>(values); }));
+        check(Measure("reduce", reps, [&] { return sum_reduce<float>(values, {}); }));
+        check(Measure("reduce, pairwise", reps, [&] { return sum_reduce<float>(values, { .method = summation::pairwise }); }));
+        check(Measure("reduce, Kahan", reps, [&] { return sum_reduce<float>(values, { .method = summation::kahan }); }));
+        if (max_nthreads > 1) {
+            thread_pool pool(max_nthreads);
+            const auto name = "reduce, Kahan, " + std::to_string(max_nthreads) + " threads";
+            check(Measure(name, reps, [&] { return sum_reduce<float>(values, { .pool = &pool, .method = summation::kahan }); }));
+        }
+    }
+
+    // The series of the ranges snippets of 03_02, which converges to
+    // pi^2 / 6. With a bounded iota instead of take, it is a sized
+    // random-access range, so reduce splits it like a vector. The terms get
+    // smaller and smaller, so a plain sum rounds off more and more of each
+    // of them, and compensated summation keeps track of that. The reference
+    // adds the smallest terms first, in long double.
+    std::cout << "1 / n^2 series" << std::endl;
+    {
+        const auto series = std::views::iota(1LL, 1'000'001LL)
+                            | std::views::transform([](auto v) { return v * v; })
+                            | std::views::transform([](auto v) { return 1.0 / v; });
+        static_assert(reduce_detail::is_splittable<decltype(series)&>);
+        long double exact = 0;
+        for (auto idx = series.size(); idx > 0; --idx) {
+            exact += series[idx - 1];
+        }
+        const auto check = [&](double result) {
+            std::cout << ", error " << double(std::abs(result - exact)) << std::endl;
+        };
+
+        check(Measure("reduce", reps, [&] { return reduce(series, 0.0, std::plus{}); }));
+        check(Measure("reduce, Kahan", reps, [&] { return reduce(series, 0.0, std::plus{}, { .method = summation::kahan }); }));
+    }
+
+    trace_write_chrome_json("03_01_reduce_benchmark.trace.json");
+}
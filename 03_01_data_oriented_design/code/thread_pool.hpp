@@ -0,0 +1,156 @@
+#pragma once
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+// Half-open range of indices [first, last).
+struct index_range {
+    size_t first;
+    size_t last;
+
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+};
+
+
+// Part part_idx of nparts nearly equal, contiguous parts of the range. Part
+// boundaries are multiples of grain (relative to range.first), e.g. so that
+// no two threads write to the same cache line.
+inline index_range static_partition(index_range range, size_t part_idx, size_t nparts, size_t grain = 1) {
+    const size_t nblocks = (range.size() + grain - 1) / grain;
+    const size_t first_block = nblocks * part_idx / nparts;
+    const size_t last_block = nblocks * (part_idx + 1) / nparts;
+    return {
+        std::min(range.last, range.first + first_block * grain),
+        std::min(range.last, range.first + last_block * grain),
+    };
+}
+
+
+// A fixed set of threads that are started once and then wait for work, so
+// that a parallel loop only pays for waking them up, not for creating them.
+// The thread that calls run_on_all or parallel_for takes part as thread 0.
+// Only one thread may submit work at a time, and work must not submit work
+// to the same pool again.
+class thread_pool {
+public:
+    explicit thread_pool(size_t nthreads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t thread_idx = 1; thread_idx < nthreads; ++thread_idx) {
+            m_workers.emplace_back([this, thread_idx] { work(thread_idx); });
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_start.notify_all();
+        std::ranges::for_each(m_workers, [](auto& th) { th.join(); });
+    }
+
+    size_t size() const { return m_workers.size() + 1; }
+
+    // Call fun(thread_idx) on every thread of the pool and wait for all of
+    // them. The first exception thrown by fun is rethrown here.
+    template <class Fun>
+    void run_on_all(Fun&& fun) {
+        auto call = [&fun](size_t thread_idx) { fun(thread_idx); };
+        run([](void* context, size_t thread_idx) { (*static_cast<decltype(call)*>(context))(thread_idx); }, &call);
+    }
+
+    // Statically partition the range over the threads of the pool, and call
+    // fun(part, thread_idx) for the non-empty parts.
+    template <class Fun>
+    void parallel_for(index_range range, size_t grain, Fun&& fun) {
+        const size_t nparts = size();
+        run_on_all([&](size_t thread_idx) {
+            const auto part = static_partition(range, thread_idx, nparts, grain);
+            if (!part.empty()) {
+                fun(part, thread_idx);
+            }
+        });
+    }
+
+private:
+    using job = void (*)(void* context, size_t thread_idx);
+
+    void run(job job, void* context) {
+        {
+            std::lock_guard lock(m_mutex);
+            m_job = job;
+            m_context = context;
+            m_pending = m_workers.size();
+            m_exception = nullptr;
+            ++m_generation;
+        }
+        m_start.notify_all();
+
+        execute(job, context, 0);
+
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [this] { return m_pending == 0; });
+        if (m_exception) {
+            std::rethrow_exception(std::exchange(m_exception, nullptr));
+        }
+    }
+
+    void work(size_t thread_idx) {
+        uint64_t generation = 0;
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            m_start.wait(lock, [&] { return m_stop || m_generation != generation; });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+            const auto job = m_job;
+            const auto context = m_context;
+
+            lock.unlock();
+            execute(job, context, thread_idx);
+            lock.lock();
+
+            if (--m_pending == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    void execute(job job, void* context, size_t thread_idx) {
+        TRACE_SCOPE("thread_pool job");
+        try {
+            job(context, thread_idx);
+        }
+        catch (...) {
+            std::lock_guard lock(m_mutex);
+            if (!m_exception) {
+                m_exception = std::current_exception();
+            }
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_start;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    size_t m_pending = 0;
+    bool m_stop = false;
+    job m_job = nullptr;
+    void* m_context = nullptr;
+    std::exception_ptr m_exception;
+    std::vector<std::thread> m_workers;
+};
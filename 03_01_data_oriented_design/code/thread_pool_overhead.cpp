@@ -0,0 +1,104 @@
+#include "per_thread.hpp"
+#include "perf_counters.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Create and join a fresh std::thread for each part, on every call.
+int64_t sum_spawn(std::span<const int64_t> values, size_t nthreads) {
+    per_thread<int64_t> partition_sums(nthreads, 0);
+    std::vector<std::thread> threads;
+
+    for (size_t thread_idx = 0; thread_idx < nthreads; ++thread_idx) {
+        threads.push_back(std::thread([&partition_sums, values, nthreads, thread_idx] {
+            const auto part = static_partition({ 0, values.size() }, thread_idx, nthreads, 8);
+            partition_sums[thread_idx] = std::reduce(values.begin() + part.first, values.begin() + part.last, int64_t(0));
+        }));
+    }
+
+    std::ranges::for_each(threads, [](auto& th) { th.join(); });
+    return partition_sums.combine(std::plus{});
+}
+
+
+// Wake up the threads of a pool that has been created up front.
+int64_t sum_pool(thread_pool& pool, std::span<const int64_t> values) {
+    per_thread<int64_t> partition_sums(pool.size(), 0);
+
+    pool.parallel_for({ 0, values.size() }, 8, [&](index_range part, size_t thread_idx) {
+        partition_sums[thread_idx] = std::reduce(values.begin() + part.first, values.begin() + part.last, int64_t(0));
+    });
+
+    return partition_sums.combine(std::plus{});
+}
+
+
+template <class Algorithm>
+double MeasureMicroseconds(const std::string& name, size_t reps, int64_t expected, Algorithm&& algorithm) {
+    using std::chrono::high_resolution_clock;
+
+    perf_region region(name);
+    const auto start = high_resolution_clock::now();
+    for (size_t rep = 0; rep < reps; ++rep) {
+        if (algorithm() != expected) {
+            throw std::logic_error("incorrect result");
+        }
+    }
+    const auto end = high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / reps;
+}
+
+
+int main() {
+    // Open the counters before any worker thread exists, so they count them too.
+    perf_counters::instance();
+
+    constexpr size_t max_size = 10'000'000;
+    constexpr size_t total_work = 100'000'000;
+    // Each spawn rep creates nthreads threads, which costs far more than the
+    // work for small sizes, so the spawn variant gets fewer reps.
+    constexpr size_t max_spawned_threads = 200'000;
+
+    std::vector<int64_t> values(max_size, 1);
+    const size_t max_nthreads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Powers of two, and all cores.
+    std::vector<size_t> thread_counts;
+    for (size_t nthreads = 1; nthreads < max_nthreads; nthreads *= 2) {
+        thread_counts.push_back(nthreads);
+    }
+    thread_counts.push_back(max_nthreads);
+
+    for (size_t nthreads : thread_counts) {
+        thread_pool pool(nthreads);
+        std::cout << "nthreads=" << nthreads << std::endl;
+
+        for (size_t size = 100; size <= max_size; size *= 10) {
+            const auto part = std::span<const int64_t>(values).first(size);
+            const size_t reps = std::max(size_t(10), total_work / size);
+            const size_t spawn_reps = std::max(size_t(10), std::min(reps, max_spawned_threads / nthreads));
+
+            const auto name = " size = " + std::to_string(size);
+            const auto spawn = MeasureMicroseconds("spawn" + name, spawn_reps, size, [&] { return sum_spawn(part, nthreads); });
+            const auto pooled = MeasureMicroseconds("pool" + name, reps, size, [&] { return sum_pool(pool, part); });
+
+            std::cout << "  size = " << size << ":    "
+                      << "spawn " << spawn << " us, "
+                      << "pool " << pooled << " us, "
+                      << "speedup " << spawn / pooled << "x" << std::endl;
+        }
+    }
+
+    trace_write_chrome_json("03_01_thread_pool_overhead.trace.json");
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+// Scoped tracing of hot code paths, exported as Chrome trace JSON, which can
+// be opened in chrome://tracing or https://ui.perfetto.dev.
+//
+//   void Update() {
+//       TRACE_SCOPE("Update");
+//       ...
+//   }
+//   ...
+//   trace_write_chrome_json("nbody.trace.json");
+//
+// Tracing is compiled in only if CPP_COURSE_TRACE is defined (CMake option
+// of the same name). Otherwise TRACE_SCOPE expands to nothing and
+// trace_write_chrome_json does nothing.
+//
+// Each thread records into its own fixed-size ring buffer, which keeps the
+// most recent events, so recording takes two timestamp reads and a store to
+// thread-local memory, without any locks. Names must be string literals.
+// Export only when no traced code runs.
+
+#if defined(CPP_COURSE_TRACE)
+
+    #include <chrono>
+    #include <cstddef>
+    #include <cstdint>
+    #include <fstream>
+    #include <iomanip>
+    #include <memory>
+    #include <ostream>
+    #include <mutex>
+    #include <string>
+    #include <vector>
+
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #elif defined(__x86_64__) || defined(__i386__)
+        #include <x86intrin.h>
+    #endif
+
+
+// Time stamp counter on x86, the steady clock elsewhere.
+inline uint64_t trace_timestamp() {
+    #if defined(_M_X64) || defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+    #else
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+    #endif
+}
+
+
+struct trace_event {
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+
+class trace_buffer {
+public:
+    static constexpr size_t capacity = 65536;
+
+    explicit trace_buffer(size_t thread_idx) : m_thread_idx(thread_idx), m_events(capacity) {}
+
+    void record(const char* name, uint64_t begin, uint64_t end) {
+        m_events[m_count % capacity] = { name, begin, end };
+        ++m_count;
+    }
+
+    size_t thread_idx() const { return m_thread_idx; }
+
+    // Recorded events that have not been overwritten yet, oldest first.
+    std::vector<trace_event> events() const {
+        std::vector<trace_event> result;
+        const size_t first = m_count > capacity ? m_count - capacity : 0;
+        for (size_t idx = first; idx < m_count; ++idx) {
+            result.push_back(m_events[idx % capacity]);
+        }
+        return result;
+    }
+
+private:
+    size_t m_thread_idx;
+    size_t m_count = 0;
+    std::vector<trace_event> m_events;
+};
+
+
+// Owns the buffers of all threads, so that they outlive the threads.
+class trace_registry {
+public:
+    static trace_registry& instance() {
+        static trace_registry registry;
+        return registry;
+    }
+
+    trace_buffer& this_thread_buffer() {
+        thread_local trace_buffer* buffer = nullptr;
+        if (!buffer) {
+            std::lock_guard lock(m_mutex);
+            m_buffers.push_back(std::make_unique<trace_buffer>(m_buffers.size()));
+            buffer = m_buffers.back().get();
+        }
+        return *buffer;
+    }
+
+    // Writes name as a JSON string, with quotes, backslashes and control
+    // characters escaped.
+    static void write_json_string(std::ostream& os, const char* name) {
+        os << '"';
+        for (; *name; ++name) {
+            const auto c = static_cast<unsigned char>(*name);
+            if (c == '"' || c == '\\') {
+                os << '\\' << char(c);
+            }
+            else if (c < 0x20) {
+                os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c) << std::dec << std::setfill(' ');
+            }
+            else {
+                os << char(c);
+            }
+        }
+        os << '"';
+    }
+
+    void write_chrome_json(const std::string& path) {
+        std::lock_guard lock(m_mutex);
+
+        // Calibrate timestamps against the steady clock over the lifetime of
+        // the registry, to convert them to microseconds.
+        const auto end_time = std::chrono::steady_clock::now();
+        const auto end_timestamp = trace_timestamp();
+        const double elapsed_us = std::chrono::duration<double, std::micro>(end_time - m_start_time).count();
+        const double ticks_per_us = double(end_timestamp - m_start_timestamp) / elapsed_us;
+        const auto to_us = [&](uint64_t timestamp) { return double(timestamp - m_start_timestamp) / ticks_per_us; };
+
+        std::ofstream os(path);
+        os << std::fixed << std::setprecision(3);
+        os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+        bool first = true;
+        for (const auto& buffer : m_buffers) {
+            os << (first ? "" : ",\n")
+               << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->thread_idx()
+               << ",\"args\":{\"name\":\"thread " << buffer->thread_idx() << "\"}}";
+            first = false;
+            for (const auto& event : buffer->events()) {
+                os << ",\n{\"name\":";
+                write_json_string(os, event.name);
+                os << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->thread_idx()
+                   << ",\"ts\":" << to_us(event.begin)
+                   << ",\"dur\":" << to_us(event.end) - to_us(event.begin) << "}";
+            }
+        }
+        os << "\n]}\n";
+    }
+
+private:
+    trace_registry() : m_start_time(std::chrono::steady_clock::now()), m_start_timestamp(trace_timestamp()) {}
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<trace_buffer>> m_buffers;
+    std::chrono::steady_clock::time_point m_start_time;
+    uint64_t m_start_timestamp;
+};
+
+
+class trace_scope {
+public:
+    // The registry is created first, so that its calibration starts before
+    // the first event.
+    explicit trace_scope(const char* name)
+        : m_buffer(trace_registry::instance().this_thread_buffer()), m_name(name), m_begin(trace_timestamp()) {}
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+    ~trace_scope() {
+        m_buffer.record(m_name, m_begin, trace_timestamp());
+    }
+
+private:
+    trace_buffer& m_buffer;
+    const char* m_name;
+    uint64_t m_begin;
+};
+
+
+inline void trace_write_chrome_json(const std::string& path) {
+    trace_registry::instance().write_chrome_json(path);
+}
+
+    #define TRACE_CONCAT_IMPL(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+    #define TRACE_SCOPE(name) trace_scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+#else
+
+inline void trace_write_chrome_json(const char*) {}
+
+    #define TRACE_SCOPE(name)
+
+#endif
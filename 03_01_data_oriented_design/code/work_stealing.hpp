@@ -0,0 +1,222 @@
+#pragma once
+
+#include "per_thread.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+
+
+// Chase-Lev work-stealing deque of index ranges, with the memory orders of
+// Le et al., "Correct and Efficient Work-Stealing for Weak Memory Models".
+// The owner thread pushes and pops at the bottom (LIFO), other threads steal
+// from the top (FIFO), which is where the oldest, i.e. largest ranges are.
+class chase_lev_deque {
+    // The ranges are stored as two atomics, so that a thief reading a slot
+    // that the owner overwrites at the same time is not a data race. The
+    // thief's compare-exchange on top fails in that case anyway.
+    struct slot {
+        std::atomic<size_t> first;
+        std::atomic<size_t> last;
+    };
+
+    struct ring {
+        explicit ring(int64_t capacity) : capacity(capacity), slots(new slot[capacity]) {}
+
+        index_range load(int64_t idx) const {
+            const auto& s = slots[idx & (capacity - 1)];
+            return { s.first.load(std::memory_order_relaxed), s.last.load(std::memory_order_relaxed) };
+        }
+        void store(int64_t idx, index_range range) {
+            auto& s = slots[idx & (capacity - 1)];
+            s.first.store(range.first, std::memory_order_relaxed);
+            s.last.store(range.last, std::memory_order_relaxed);
+        }
+
+        const int64_t capacity;
+        std::unique_ptr<slot[]> slots;
+    };
+
+public:
+    explicit chase_lev_deque(int64_t capacity = 64) {
+        m_rings.push_back(std::make_unique<ring>(capacity));
+        m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    // Owner only.
+    void push(index_range range) {
+        const auto b = m_bottom.load(std::memory_order_relaxed);
+        const auto t = m_top.load(std::memory_order_acquire);
+        auto r = m_ring.load(std::memory_order_relaxed);
+        if (b - t > r->capacity - 1) {
+            r = grow(r, t, b);
+        }
+        r->store(b, range);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Owner only.
+    std::optional<index_range> pop() {
+        const auto b = m_bottom.load(std::memory_order_relaxed) - 1;
+        const auto r = m_ring.load(std::memory_order_relaxed);
+        m_bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto t = m_top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+        const auto range = r->load(b);
+        if (t == b) {
+            // Last item: race against the thieves for it.
+            const bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+            if (!won) {
+                return std::nullopt;
+            }
+        }
+        return range;
+    }
+
+    // Any thread.
+    std::optional<index_range> steal() {
+        auto t = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto b = m_bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return std::nullopt;
+        }
+        const auto r = m_ring.load(std::memory_order_acquire);
+        const auto range = r->load(t);
+        if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return std::nullopt;
+        }
+        return range;
+    }
+
+    // Owner only, while no other thread can steal.
+    void clear() {
+        m_bottom.store(m_top.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+private:
+    ring* grow(ring* old, int64_t t, int64_t b) {
+        auto bigger = std::make_unique<ring>(2 * old->capacity);
+        for (auto idx = t; idx < b; ++idx) {
+            bigger->store(idx, old->load(idx));
+        }
+        // Thieves may still read from the old ring, so it stays alive until
+        // the deque is destroyed. The rings double, so that wastes at most
+        // as much memory as the current ring has.
+        m_rings.push_back(std::move(bigger));
+        m_ring.store(m_rings.back().get(), std::memory_order_release);
+        return m_rings.back().get();
+    }
+
+    alignas(cache_line_size) std::atomic<int64_t> m_top = 0;
+    alignas(cache_line_size) std::atomic<int64_t> m_bottom = 0;
+    alignas(cache_line_size) std::atomic<ring*> m_ring;
+    std::vector<std::unique_ptr<ring>> m_rings;
+};
+
+
+// Parallel loops with dynamic load balancing on top of the threads of a
+// thread_pool. A thread splits its range in halves down to the grain size,
+// keeps working on the lower half and pushes the upper half to its deque.
+// Idle threads steal from the top of the deques of other threads, which is
+// where the biggest ranges are, i.e. they take over half of someone's work.
+class work_stealing_scheduler {
+public:
+    explicit work_stealing_scheduler(thread_pool& pool) : m_pool(pool) {
+        for (size_t thread_idx = 0; thread_idx < pool.size(); ++thread_idx) {
+            m_deques.push_back(std::make_unique<chase_lev_deque>());
+        }
+    }
+
+    size_t size() const { return m_pool.size(); }
+
+    // Call fun(part, thread_idx) for parts of at most grain indices that
+    // cover the range, in parallel. Parts are aligned to multiples of grain
+    // relative to range.first.
+    template <class Fun>
+    void parallel_for(index_range range, size_t grain, Fun&& fun) {
+        for (auto& deque : m_deques) {
+            deque->clear();
+        }
+        m_remaining.store(range.size(), std::memory_order_relaxed);
+        m_abort.store(false, std::memory_order_relaxed);
+
+        m_pool.run_on_all([&](size_t thread_idx) {
+            auto& deque = *m_deques[thread_idx];
+            uint64_t rng_state = 0x9E3779B97F4A7C15ull * (thread_idx + 1);
+
+            std::optional<index_range> current;
+            if (thread_idx == 0) {
+                current = range;
+            }
+            while (m_remaining.load(std::memory_order_acquire) > 0 && !m_abort.load(std::memory_order_relaxed)) {
+                if (!current) {
+                    current = deque.pop();
+                }
+                if (!current) {
+                    current = steal(thread_idx, rng_state);
+                }
+                if (!current) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                auto part = *current;
+                current.reset();
+                while (part.size() > grain) {
+                    const size_t nblocks = (part.size() + grain - 1) / grain;
+                    const size_t mid = part.first + nblocks / 2 * grain;
+                    deque.push({ mid, part.last });
+                    part.last = mid;
+                }
+                try {
+                    TRACE_SCOPE("work_stealing part");
+                    fun(part, thread_idx);
+                }
+                catch (...) {
+                    m_abort.store(true, std::memory_order_relaxed);
+                    throw;
+                }
+                m_remaining.fetch_sub(part.size(), std::memory_order_acq_rel);
+            }
+        });
+    }
+
+private:
+    std::optional<index_range> steal(size_t thread_idx, uint64_t& rng_state) {
+        // xorshift64 to pick the first victim at random.
+        rng_state ^= rng_state << 13;
+        rng_state ^= rng_state >> 7;
+        rng_state ^= rng_state << 17;
+
+        const size_t nthreads = m_deques.size();
+        for (size_t offset = 0; offset < nthreads; ++offset) {
+            const size_t victim = (rng_state + offset) % nthreads;
+            if (victim == thread_idx) {
+                continue;
+            }
+            if (auto range = m_deques[victim]->steal()) {
+                return range;
+            }
+        }
+        return std::nullopt;
+    }
+
+    thread_pool& m_pool;
+    std::vector<std::unique_ptr<chase_lev_deque>> m_deques;
+    alignas(cache_line_size) std::atomic<size_t> m_remaining = 0;
+    std::atomic<bool> m_abort = false;
+};
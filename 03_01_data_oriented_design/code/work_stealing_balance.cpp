@@ -0,0 +1,100 @@
+#include "per_thread.hpp"
+#include "perf_counters.hpp"
+#include "thread_pool.hpp"
+#include "trace.hpp"
+#include "work_stealing.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _MSC_VER
+    #define NOINLINE __declspec(noinline)
+#else
+    #define NOINLINE __attribute__((noinline))
+#endif
+
+
+// Same amount of work for every index.
+NOINLINE int64_t uniform_kernel(index_range part, size_t n) {
+    int64_t sum = 0;
+    for (size_t i = part.first; i < part.last; ++i) {
+        for (size_t j = 0; j < n / 2; ++j) {
+            sum += (i ^ j) & 1;
+        }
+    }
+    return sum;
+}
+
+
+// Index i interacts with all j < i, like the pair loop of the n-body force
+// calculation: the last indices are much more work than the first ones.
+NOINLINE int64_t triangular_kernel(index_range part, size_t /*n*/) {
+    int64_t sum = 0;
+    for (size_t i = part.first; i < part.last; ++i) {
+        for (size_t j = 0; j < i; ++j) {
+            sum += (i ^ j) & 1;
+        }
+    }
+    return sum;
+}
+
+
+template <class Scheduler, class Kernel>
+int64_t run(Scheduler& scheduler, size_t n, size_t grain, Kernel kernel) {
+    per_thread<int64_t> sums(scheduler.size(), 0);
+    scheduler.parallel_for({ 0, n }, grain, [&](index_range part, size_t thread_idx) {
+        sums[thread_idx] += kernel(part, n);
+    });
+    return sums.combine(std::plus{});
+}
+
+
+int main() {
+    using std::chrono::high_resolution_clock;
+    using std::chrono::milliseconds;
+
+    // Open the counters before any worker thread exists, so they count them too.
+    perf_counters::instance();
+
+    constexpr size_t n = 40'000;
+    constexpr size_t stealing_grain = 64;
+    const size_t max_nthreads = std::max(1u, std::thread::hardware_concurrency());
+
+    const int64_t uniform_expected = uniform_kernel({ 0, n }, n);
+    const int64_t triangular_expected = triangular_kernel({ 0, n }, n);
+
+    const auto measure = [&](const char* name, int64_t expected, auto&& algorithm) {
+        perf_region region(name);
+        const auto start = high_resolution_clock::now();
+        const auto result = algorithm();
+        const auto end = high_resolution_clock::now();
+        if (result != expected) {
+            throw std::logic_error("incorrect result");
+        }
+        std::cout << "  " << std::left << std::setw(24) << std::string(name) + ":"
+                  << duration_cast<milliseconds>(end - start).count() << " ms"
+                  << std::endl;
+    };
+
+    for (size_t nthreads = 1; nthreads <= max_nthreads; ++nthreads) {
+        thread_pool pool(nthreads);
+        work_stealing_scheduler stealing(pool);
+        // The static partitioner always cuts the range in nthreads parts.
+        const size_t static_grain = 1;
+
+        std::cout << "nthreads=" << nthreads << std::endl;
+        measure("uniform, static", uniform_expected, [&] { return run(pool, n, static_grain, uniform_kernel); });
+        measure("uniform, stealing", uniform_expected, [&] { return run(stealing, n, stealing_grain, uniform_kernel); });
+        measure("triangular, static", triangular_expected, [&] { return run(pool, n, static_grain, triangular_kernel); });
+        measure("triangular, stealing", triangular_expected, [&] { return run(stealing, n, stealing_grain, triangular_kernel); });
+    }
+
+    trace_write_chrome_json("03_01_work_stealing_balance.trace.json");
+}
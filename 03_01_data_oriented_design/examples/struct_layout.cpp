@@ -5,6 +5,8 @@
 // try removing the PKind from the structure foe example
 // think about how the array of structs approach might become
 // better/competitive
+#include "../code/perf_counters.hpp"
+
 #include <algorithm>
 #include <compare>
 #include <cstdint>
@@ -748,30 +750,47 @@ TEST_CASE("StructLayout") {
         REQUIRE_THAT(sys5.sumCenterOfMass(), WithinAbs(cMass, 1.0e-10) || WithinRel(cMass));
         const int steps = 2;
 
-        BENCHMARK("originalLayout") {
-            for (int i = 0; i < steps; ++i)
-                sys.advance();
-            return sys.sumCenterOfMass();
-        };
-        BENCHMARK("betterLayout") {
-            for (int i = 0; i < steps; ++i)
-                sys2.advance();
-            return sys2.sumCenterOfMass();
-        };
-        BENCHMARK("betterLayoutCentralized") {
-            for (int i = 0; i < steps; ++i)
-                sys3.advance();
-            return sys3.sumCenterOfMass();
-        };
-        BENCHMARK("CentralizedSoA") {
-            for (int i = 0; i < steps; ++i)
-                sys4.advance();
-            return sys4.sumCenterOfMass();
-        };
-        BENCHMARK("MultiLoopSoA") {
-            for (int i = 0; i < steps; ++i)
-                sys5.advance();
-            return sys5.sumCenterOfMass();
-        };
+        // The perf regions cover all runs Catch2 makes of a benchmark, so
+        // compare ratios like IPC and MPKI between them rather than totals.
+        {
+            perf_region region("originalLayout N=" + std::to_string(N));
+            BENCHMARK("originalLayout") {
+                for (int i = 0; i < steps; ++i)
+                    sys.advance();
+                return sys.sumCenterOfMass();
+            };
+        }
+        {
+            perf_region region("betterLayout N=" + std::to_string(N));
+            BENCHMARK("betterLayout") {
+                for (int i = 0; i < steps; ++i)
+                    sys2.advance();
+                return sys2.sumCenterOfMass();
+            };
+        }
+        {
+            perf_region region("betterLayoutCentralized N=" + std::to_string(N));
+            BENCHMARK("betterLayoutCentralized") {
+                for (int i = 0; i < steps; ++i)
+                    sys3.advance();
+                return sys3.sumCenterOfMass();
+            };
+        }
+        {
+            perf_region region("CentralizedSoA N=" + std::to_string(N));
+            BENCHMARK("CentralizedSoA") {
+                for (int i = 0; i < steps; ++i)
+                    sys4.advance();
+                return sys4.sumCenterOfMass();
+            };
+        }
+        {
+            perf_region region("MultiLoopSoA N=" + std::to_string(N));
+            BENCHMARK("MultiLoopSoA") {
+                for (int i = 0; i < steps; ++i)
+                    sys5.advance();
+                return sys5.sumCenterOfMass();
+            };
+        }
     }
 }
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "executor.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <system_error>
+#include <thread>
+
+#include <cerrno>
+#include <climits>
+#include <sys/types.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define ASYNC_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+
+// Asynchronous file I/O for coroutines:
+//     const size_t n = co_await async_read(fd, buffer, offset);
+//     co_await async_write(fd, data, offset);
+// suspend the coroutine until the operation is done, and return the number of
+// bytes transferred, which like for pread and pwrite may be less than asked
+// for. Errors are thrown as std::system_error.
+//
+// On Linux, operations go to an io_uring: the submitting thread only writes a
+// submission queue entry and enters the kernel once, and a completion thread
+// of the io_service resumes the coroutines when the kernel is done. Elsewhere,
+// or where io_uring is disabled (it often is in containers), a pool of
+// threads does blocking pread and pwrite calls instead. Either way the
+// coroutine continues on a thread of the io_service, so it should move onto a
+// scheduler before doing heavy work with the data, and the buffer must stay
+// alive until the operation is done.
+
+
+enum class io_backend {
+    automatic,
+    io_uring,
+    thread_pool,
+};
+
+
+class io_service;
+
+
+// The awaitable of async_read and async_write. It lives in the frame of the
+// suspended coroutine until the operation is done.
+struct io_operation {
+    io_service* m_service;
+    bool m_write;
+    int m_fd;
+    std::byte* m_data;
+    size_t m_size;
+    off_t m_offset;
+    ssize_t m_result = 0;
+    std::coroutine_handle<> m_awaiting;
+
+    constexpr bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> awaiting);
+
+    size_t await_resume() const {
+        if (m_result < 0) {
+            throw std::system_error(int(-m_result), std::system_category(), m_write ? "async_write" : "async_read");
+        }
+        return size_t(m_result);
+    }
+
+    // Called on the thread that completes the operation, with the result or
+    // minus the error number.
+    void complete(ssize_t result) {
+        m_result = result;
+        m_awaiting.resume();
+    }
+};
+
+
+#ifdef ASYNC_IO_URING
+
+namespace async_io_detail {
+
+// The rings shared with the kernel, set up with raw system calls to do
+// without liburing.
+class uring {
+public:
+    explicit uring(unsigned entries, unsigned cq_entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = cq_entries;
+        m_fd = int(syscall(__NR_io_uring_setup, entries, &params));
+        if (m_fd < 0) {
+            throw std::system_error(errno, std::system_category(), "io_uring_setup");
+        }
+
+        m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        m_sq = map(m_sq_size, IORING_OFF_SQ_RING);
+        m_cq = map(m_cq_size, IORING_OFF_CQ_RING);
+        m_sqes = static_cast<io_uring_sqe*>(map(m_sqes_size, IORING_OFF_SQES));
+        if (!m_sq || !m_cq || !m_sqes) {
+            const int error = errno;
+            release();
+            throw std::system_error(error, std::system_category(), "io_uring mmap");
+        }
+
+        const auto sq = static_cast<std::byte*>(m_sq);
+        m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        m_sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        const auto cq = static_cast<std::byte*>(m_cq);
+        m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        m_cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    uring(const uring&) = delete;
+    uring& operator=(const uring&) = delete;
+
+    ~uring() {
+        release();
+    }
+
+    // Every entry is submitted right away, so the submission queue never
+    // holds more than one.
+    void submit(uint8_t opcode, int fd, void* data, size_t size, off_t offset, uint64_t user_data) {
+        std::lock_guard lock(m_submit_mutex);
+        const unsigned tail = *m_sq_tail;
+        const unsigned idx = tail & m_sq_mask;
+        io_uring_sqe& sqe = m_sqes[idx];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uint64_t>(data);
+        // A longer transfer is cut short, like a short pread or pwrite.
+        sqe.len = unsigned(std::min<size_t>(size, UINT_MAX));
+        sqe.off = uint64_t(offset);
+        sqe.user_data = user_data;
+        m_sq_array[idx] = idx;
+        std::atomic_ref(*m_sq_tail).store(tail + 1, std::memory_order_release);
+        while (enter(1, 0, 0) < 0) {
+            if (errno != EINTR && errno != EAGAIN) {
+                const int error = errno;
+                // The kernel did not take the entry, and would submit it on
+                // the next enter, after the caller gave up on the operation.
+                std::atomic_ref(*m_sq_tail).store(tail, std::memory_order_release);
+                throw std::system_error(error, std::system_category(), "io_uring_enter");
+            }
+        }
+    }
+
+    // Waits for at least one completion, and calls fun(user_data, result)
+    // for each. Returns false as soon as fun does.
+    template <class Fun>
+    bool complete(Fun&& fun) {
+        if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            throw std::system_error(errno, std::system_category(), "io_uring_enter");
+        }
+        unsigned head = *m_cq_head;
+        const unsigned tail = std::atomic_ref(*m_cq_tail).load(std::memory_order_acquire);
+        while (head != tail) {
+            const io_uring_cqe cqe = m_cqes[head & m_cq_mask];
+            ++head;
+            // Free the entry before calling fun, which may resume a coroutine
+            // that submits more.
+            std::atomic_ref(*m_cq_head).store(head, std::memory_order_release);
+            if (!fun(cqe.user_data, cqe.res)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    void* map(size_t size, off_t offset) const {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, offset);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    int enter(unsigned to_submit, unsigned min_complete, unsigned flags) const {
+        return int(syscall(__NR_io_uring_enter, m_fd, to_submit, min_complete, flags, nullptr, 0));
+    }
+
+    void release() noexcept {
+        if (m_sqes) {
+            munmap(m_sqes, m_sqes_size);
+        }
+        if (m_cq) {
+            munmap(m_cq, m_cq_size);
+        }
+        if (m_sq) {
+            munmap(m_sq, m_sq_size);
+        }
+        close(m_fd);
+    }
+
+    int m_fd = -1;
+    void* m_sq = nullptr;
+    void* m_cq = nullptr;
+    io_uring_sqe* m_sqes = nullptr;
+    size_t m_sq_size = 0;
+    size_t m_cq_size = 0;
+    size_t m_sqes_size = 0;
+
+    unsigned* m_sq_tail = nullptr;
+    unsigned m_sq_mask = 0;
+    unsigned* m_sq_array = nullptr;
+    unsigned* m_cq_head = nullptr;
+    unsigned* m_cq_tail = nullptr;
+    unsigned m_cq_mask = 0;
+    io_uring_cqe* m_cqes = nullptr;
+
+    std::mutex m_submit_mutex;
+};
+
+} // namespace async_io_detail
+
+#endif
+
+
+class io_service {
+public:
+    explicit io_service(io_backend backend = io_backend::automatic, size_t nthreads = 4) {
+#ifdef ASYNC_IO_URING
+        if (backend != io_backend::thread_pool) {
+            try {
+                m_ring = std::make_unique<async_io_detail::uring>(64, max_in_flight);
+                m_completion_thread = std::thread([this] { complete(); });
+                return;
+            }
+            catch (const std::system_error&) {
+                if (backend == io_backend::io_uring) {
+                    throw;
+                }
+            }
+        }
+#else
+        if (backend == io_backend::io_uring) {
+            throw std::system_error(std::make_error_code(std::errc::function_not_supported), "io_uring");
+        }
+#endif
+        m_pool = std::make_unique<executor>(nthreads);
+    }
+
+    io_service(const io_service&) = delete;
+    io_service& operator=(const io_service&) = delete;
+
+    // Waits for the operations in flight.
+    ~io_service() {
+#ifdef ASYNC_IO_URING
+        if (m_ring) {
+            for (unsigned in_flight; (in_flight = m_in_flight.load(std::memory_order_acquire)) != 0;) {
+                m_in_flight.wait(in_flight, std::memory_order_acquire);
+            }
+            m_ring->submit(IORING_OP_NOP, -1, nullptr, 0, 0, stop_marker);
+            m_completion_thread.join();
+        }
+#endif
+    }
+
+    bool uses_io_uring() const {
+#ifdef ASYNC_IO_URING
+        return bool(m_ring);
+#else
+        return false;
+#endif
+    }
+
+    void submit(io_operation& op) {
+#ifdef ASYNC_IO_URING
+        if (m_ring) {
+            // Read before the increment that publishes the operation to the
+            // completion thread.
+            const io_operation request = op;
+            if (std::this_thread::get_id() != m_completion_thread.get_id()) {
+                wait_for_slot();
+            }
+            else {
+                // The completion thread must not wait for itself. The kernel
+                // keeps completions beyond the size of the queue.
+                m_in_flight.fetch_add(1, std::memory_order_release);
+            }
+            try {
+                m_ring->submit(request.m_write ? IORING_OP_WRITE : IORING_OP_READ, request.m_fd, request.m_data,
+                               request.m_size, request.m_offset, reinterpret_cast<uint64_t>(&op));
+            }
+            catch (...) {
+                // Nothing will complete, and the exception resumes the
+                // coroutine from await_suspend.
+                m_in_flight.fetch_sub(1, std::memory_order_release);
+                m_in_flight.notify_all();
+                throw;
+            }
+            return;
+        }
+#endif
+        m_pool->post([&op] {
+            const ssize_t result = op.m_write ? ::pwrite(op.m_fd, op.m_data, op.m_size, op.m_offset)
+                                              : ::pread(op.m_fd, op.m_data, op.m_size, op.m_offset);
+            op.complete(result < 0 ? -ssize_t(errno) : result);
+        });
+    }
+
+private:
+#ifdef ASYNC_IO_URING
+    // Submitting threads wait while the completion queue is full, rather than
+    // overflowing it.
+    static constexpr unsigned max_in_flight = 4096;
+    static constexpr uint64_t stop_marker = 0;
+
+    void wait_for_slot() {
+        unsigned in_flight = m_in_flight.load(std::memory_order_relaxed);
+        do {
+            while (in_flight >= max_in_flight) {
+                m_in_flight.wait(in_flight, std::memory_order_relaxed);
+                in_flight = m_in_flight.load(std::memory_order_relaxed);
+            }
+        } while (!m_in_flight.compare_exchange_weak(in_flight, in_flight + 1, std::memory_order_release,
+                                                    std::memory_order_relaxed));
+    }
+
+    void complete() {
+        while (m_ring->complete([this](uint64_t user_data, int result) {
+            if (user_data == stop_marker) {
+                return false;
+            }
+            // Pairs with the increment in submit, so that the operation and
+            // the frame it lives in are visible here. The kernel orders them
+            // anyway, but that is outside of what C++ (and TSan) can see.
+            m_in_flight.load(std::memory_order_acquire);
+            const auto op = reinterpret_cast<io_operation*>(user_data);
+            op->complete(result);
+            m_in_flight.fetch_sub(1, std::memory_order_release);
+            m_in_flight.notify_all();
+            return true;
+        })) {
+        }
+    }
+
+    std::unique_ptr<async_io_detail::uring> m_ring;
+    std::thread m_completion_thread;
+    std::atomic<unsigned> m_in_flight = 0;
+#endif
+    std::unique_ptr<executor> m_pool;
+};
+
+
+inline void io_operation::await_suspend(std::coroutine_handle<> awaiting) {
+    m_awaiting = awaiting;
+    // The operation may complete and resume the coroutine on another thread
+    // before submit returns, so nothing may touch *this after it.
+    m_service->submit(*this);
+}
+
+
+inline io_service& default_io_service() {
+    static io_service service;
+    return service;
+}
+
+
+inline io_operation async_read(int fd, std::span<std::byte> buffer, off_t offset, io_service& service = default_io_service()) {
+    return { &service, false, fd, buffer.data(), buffer.size(), offset, 0, {} };
+}
+
+
+inline io_operation async_write(int fd, std::span<const std::byte> data, off_t offset, io_service& service = default_io_service()) {
+    return { &service, true, fd, const_cast<std::byte*>(data.data()), data.size(), offset, 0, {} };
+}
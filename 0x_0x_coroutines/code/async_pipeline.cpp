@@ -0,0 +1,192 @@
+#include "async_io.hpp"
+#include "scheduler.hpp"
+#include "task.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+
+// Streams a file of doubles, like a series of particle snapshots, through a
+// computation, chunk by chunk. The serial pipeline reads a chunk, then
+// computes on it. The overlapped one reads the next chunk while it computes
+// on the current one, and takes about as long as the slower of the two.
+
+
+constexpr size_t chunk_length = 1 << 19;
+constexpr size_t chunk_size = chunk_length * sizeof(double);
+constexpr size_t num_chunks = 64;
+constexpr size_t passes = 6;
+
+
+double generate(size_t chunk, size_t idx) {
+    return double(chunk * chunk_length + idx);
+}
+
+
+// Some computation that takes about as long as reading the chunk from disk.
+double process(std::span<const double> chunk) {
+    double sum = 0;
+    for (size_t pass = 0; pass < passes; ++pass) {
+        for (double x : chunk) {
+            sum += std::sqrt(x + double(pass));
+        }
+    }
+    return sum;
+}
+
+
+task<void> write_file(io_service& io, int fd) {
+    std::vector<double> values(chunk_length);
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        for (size_t idx = 0; idx < chunk_length; ++idx) {
+            values[idx] = generate(chunk, idx);
+        }
+        const auto bytes = std::as_bytes(std::span(values));
+        size_t done = 0;
+        while (done < bytes.size()) {
+            done += co_await async_write(fd, bytes.subspan(done), off_t(chunk * chunk_size + done), io);
+        }
+    }
+}
+
+
+task<void> read_chunk(io_service& io, int fd, std::span<double> values, size_t chunk) {
+    const auto buffer = std::as_writable_bytes(values);
+    size_t done = 0;
+    while (done < buffer.size()) {
+        const size_t n = co_await async_read(fd, buffer.subspan(done), off_t(chunk * chunk_size + done), io);
+        if (n == 0) {
+            throw std::runtime_error("unexpected end of file");
+        }
+        done += n;
+    }
+}
+
+
+task<void> compute_chunk(scheduler& sched, std::span<const double> values, double& sum) {
+    co_await sched.schedule();
+    sum += process(values);
+}
+
+
+task<double> serial(io_service& io, scheduler& sched, int fd) {
+    std::vector<double> buffer(chunk_length);
+    double sum = 0;
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        co_await read_chunk(io, fd, buffer, chunk);
+        co_await compute_chunk(sched, buffer, sum);
+    }
+    co_return sum;
+}
+
+
+task<double> overlapped(io_service& io, scheduler& sched, int fd) {
+    std::vector<double> current(chunk_length);
+    std::vector<double> next(chunk_length);
+    double sum = 0;
+    co_await read_chunk(io, fd, current, 0);
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        std::vector<task<void>> steps;
+        steps.push_back(compute_chunk(sched, current, sum));
+        if (chunk + 1 < num_chunks) {
+            steps.push_back(read_chunk(io, fd, next, chunk + 1));
+        }
+        co_await when_all(std::move(steps));
+        std::swap(current, next);
+    }
+    co_return sum;
+}
+
+
+task<double> read_only(io_service& io, int fd) {
+    std::vector<double> buffer(chunk_length);
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        co_await read_chunk(io, fd, buffer, chunk);
+    }
+    co_return 0.0;
+}
+
+
+// So that reads come from the disk rather than from the page cache.
+void drop_cache(int fd) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
+
+
+template <class Fun>
+double measure(const std::string& name, int fd, Fun&& fun) {
+    drop_cache(fd);
+    const auto start = std::chrono::high_resolution_clock::now();
+    const double result = fun();
+    const auto end = std::chrono::high_resolution_clock::now();
+    std::cout << name << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    return result;
+}
+
+
+int main(int argc, char** argv) {
+    const std::string path = argc > 1 ? argv[1] : "async_pipeline.dat";
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    double expected = 0;
+    {
+        std::vector<double> values(chunk_length);
+        for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+            for (size_t idx = 0; idx < chunk_length; ++idx) {
+                values[idx] = generate(chunk, idx);
+            }
+            expected += process(values);
+        }
+    }
+
+    for (const auto backend : { io_backend::io_uring, io_backend::thread_pool }) {
+        std::unique_ptr<io_service> io;
+        try {
+            io = std::make_unique<io_service>(backend);
+        }
+        catch (const std::system_error& e) {
+            std::cout << "io_uring not available: " << e.what() << std::endl;
+            continue;
+        }
+        std::cout << (io->uses_io_uring() ? "io_uring" : "thread pool") << ":" << std::endl;
+        scheduler sched(1);
+
+        measure("    write:      ", fd, [&] {
+            sync_wait(write_file(*io, fd));
+            return 0.0;
+        });
+        measure("    read:       ", fd, [&] { return sync_wait(read_only(*io, fd)); });
+        measure("    compute:    ", fd, [&] {
+            std::vector<double> buffer(chunk_length);
+            double sum = 0;
+            for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+                sum += process(buffer);
+            }
+            return sum;
+        });
+        const double result_serial = measure("    serial:     ", fd, [&] { return sync_wait(serial(*io, sched, fd)); });
+        const double result_overlapped = measure("    overlapped: ", fd, [&] { return sync_wait(overlapped(*io, sched, fd)); });
+        if (result_serial != expected || result_overlapped != expected) {
+            throw std::logic_error("incorrect result");
+        }
+    }
+
+    close(fd);
+    unlink(path.c_str());
+}
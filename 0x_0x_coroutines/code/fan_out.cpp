@@ -0,0 +1,103 @@
+#include "scheduler.hpp"
+#include "task.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+// Some computation that takes a while and cannot be optimized away.
+double work(size_t idx, size_t iterations) {
+    double x = double(idx);
+    for (size_t i = 0; i < iterations; ++i) {
+        x = std::sqrt(x + 1.0);
+    }
+    return x;
+}
+
+
+task<double> leaf(scheduler& sched, size_t idx, size_t iterations) {
+    co_await sched.schedule();
+    co_return work(idx, iterations);
+}
+
+
+// Fan out into num_leaves tasks, and fan back in by adding up their results.
+task<double> fan_out(scheduler& sched, size_t num_leaves, size_t iterations) {
+    std::vector<task<double>> leaves;
+    leaves.reserve(num_leaves);
+    for (size_t idx = 0; idx < num_leaves; ++idx) {
+        leaves.push_back(leaf(sched, idx, iterations));
+    }
+    double sum = 0;
+    for (double x : co_await when_all(std::move(leaves))) {
+        sum += x;
+    }
+    co_return sum;
+}
+
+
+task<double> cached(double value) {
+    co_return value;
+}
+
+
+// A value that is known already wins against computing it. when_any is done
+// right away, and the computations finish in the background.
+task<size_t> race(scheduler& sched) {
+    std::vector<task<double>> runners;
+    runners.push_back(cached(work(0, 10'000'000)));
+    runners.push_back(leaf(sched, 0, 10'000'000));
+    runners.push_back(leaf(sched, 0, 10'000'000));
+    co_return (co_await when_any(std::move(runners))).first;
+}
+
+
+int main() {
+    constexpr size_t num_leaves = 1000;
+    constexpr size_t iterations = 20'000;
+
+    double expected = 0;
+    for (size_t idx = 0; idx < num_leaves; ++idx) {
+        expected += work(idx, iterations);
+    }
+
+    const size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    double time_1 = 0;
+    for (size_t nthreads = 1; nthreads <= max_threads; nthreads *= 2) {
+        scheduler sched(nthreads);
+        const auto start = std::chrono::high_resolution_clock::now();
+        const double result = sync_wait(fan_out(sched, num_leaves, iterations));
+        const auto end = std::chrono::high_resolution_clock::now();
+        if (result != expected) {
+            throw std::logic_error("incorrect result");
+        }
+
+        const double time = std::chrono::duration<double, std::milli>(end - start).count();
+        time_1 = nthreads == 1 ? time : time_1;
+        std::cout << nthreads << " threads: " << time << " ms, speedup " << time_1 / time << std::endl;
+    }
+
+    // The overhead per task, with leaves that do next to nothing.
+    {
+        constexpr size_t num_small = 1'000'000;
+        scheduler sched(max_threads);
+        const auto start = std::chrono::high_resolution_clock::now();
+        sync_wait(fan_out(sched, num_small, 0));
+        const auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "empty leaves: " << num_small / std::chrono::duration<double>(end - start).count() / 1e6
+                  << " M tasks/s" << std::endl;
+    }
+
+    {
+        scheduler sched(max_threads);
+        if (sync_wait(race(sched)) != 0) {
+            throw std::logic_error("incorrect result");
+        }
+    }
+}
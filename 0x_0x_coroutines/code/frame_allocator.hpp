@@ -0,0 +1,139 @@
+#pragma once
+
+#include "memory_resources.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <vector>
+
+
+// Allocation of coroutine frames. By default, frames come from a size class
+// pool of the thread that creates the coroutine, which takes a free list pop
+// instead of a call to malloc. A coroutine can also get its frame from a
+// memory resource passed to it (see task.hpp).
+//
+// Where the frame came from is stored behind it, so it can be given back
+// however the coroutine ends. Coroutines moved to other threads by a
+// scheduler often end on a different thread than they started. Their frames
+// are pushed to a lock-free list of the pool they came from, which the
+// owning thread takes back into its pool when it allocates next. Otherwise
+// frames would pile up in the pools of the threads that destroy them, while
+// the threads that create them keep asking for more memory.
+//
+// The pools hold on to their memory until the program exits, instead of
+// releasing it when their thread exits, since frames from them may still be
+// alive on other threads.
+
+
+class frame_pool {
+public:
+    frame_pool() : m_pool(std::pmr::new_delete_resource()) {}
+
+    // Only from the owning thread.
+    void* allocate(size_t bytes) {
+        if (m_remote.load(std::memory_order_relaxed)) {
+            reclaim_remote();
+        }
+        return m_pool.allocate(bytes, alignof(std::max_align_t));
+    }
+
+    // Only from the owning thread.
+    void deallocate(void* p, size_t bytes) noexcept {
+        m_pool.deallocate(p, bytes, alignof(std::max_align_t));
+    }
+
+    // From any other thread.
+    void deallocate_remote(void* p, size_t bytes) noexcept {
+        auto block = ::new (p) remote_block{ m_remote.load(std::memory_order_relaxed), bytes };
+        while (!m_remote.compare_exchange_weak(block->next, block, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+private:
+    struct remote_block {
+        remote_block* next;
+        size_t bytes;
+    };
+
+    void reclaim_remote() noexcept {
+        auto block = m_remote.exchange(nullptr, std::memory_order_acquire);
+        while (block) {
+            const auto next = block->next;
+            deallocate(block, block->bytes);
+            block = next;
+        }
+    }
+
+    size_class_pool m_pool;
+    std::atomic<remote_block*> m_remote = nullptr;
+};
+
+
+inline frame_pool* thread_frame_pool() {
+    thread_local frame_pool* pool = [] {
+        static std::mutex mutex;
+        static std::vector<std::unique_ptr<frame_pool>> pools;
+        std::lock_guard lock(mutex);
+        pools.push_back(std::make_unique<frame_pool>());
+        return pools.back().get();
+    }();
+    return pool;
+}
+
+
+namespace frame_detail {
+
+// Stored behind every frame. Exactly one of the two is set.
+struct frame_origin {
+    std::pmr::memory_resource* resource;
+    frame_pool* pool;
+};
+
+inline size_t origin_offset(size_t size) {
+    constexpr size_t alignment = alignof(frame_origin);
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+inline size_t allocation_size(size_t size) {
+    return origin_offset(size) + sizeof(frame_origin);
+}
+
+inline frame_origin& stored_origin(void* frame, size_t size) {
+    return *reinterpret_cast<frame_origin*>(static_cast<std::byte*>(frame) + origin_offset(size));
+}
+
+} // namespace frame_detail
+
+
+// Allocate a frame of size bytes from resource, or from the pool of this
+// thread if resource is nullptr.
+inline void* allocate_frame(size_t size, std::pmr::memory_resource* resource = nullptr) {
+    const size_t bytes = frame_detail::allocation_size(size);
+    if (resource) {
+        void* frame = resource->allocate(bytes, alignof(std::max_align_t));
+        ::new (&frame_detail::stored_origin(frame, size)) frame_detail::frame_origin{ resource, nullptr };
+        return frame;
+    }
+    const auto pool = thread_frame_pool();
+    void* frame = pool->allocate(bytes);
+    ::new (&frame_detail::stored_origin(frame, size)) frame_detail::frame_origin{ nullptr, pool };
+    return frame;
+}
+
+
+inline void deallocate_frame(void* frame, size_t size) noexcept {
+    const size_t bytes = frame_detail::allocation_size(size);
+    const auto origin = frame_detail::stored_origin(frame, size);
+    if (origin.resource) {
+        origin.resource->deallocate(frame, bytes, alignof(std::max_align_t));
+    }
+    else if (origin.pool == thread_frame_pool()) {
+        origin.pool->deallocate(frame, bytes);
+    }
+    else {
+        origin.pool->deallocate_remote(frame, bytes);
+    }
+}
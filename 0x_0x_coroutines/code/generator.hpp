@@ -0,0 +1,168 @@
+#pragma once
+
+#include "frame_allocator.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+
+// A lazy sequence written as a coroutine:
+//     generator<int> numbers_from(int value) {
+//         for (;;) {
+//             co_yield value++;
+//         }
+//     }
+// The coroutine runs up to the next co_yield each time the consumer asks for
+// the next element, and the consumer sees the yielded object itself, through
+// a const reference, instead of a copy. That is safe since the object, even a
+// temporary, lives until the coroutine resumes.
+//
+// A generator is a cursor (see cursor.hpp in 02_05), so it composes with the
+// cursor algorithms, and an input range and view, so it composes with
+// std::views. It can be iterated only once. An exception escaping the
+// coroutine is thrown from where the consumer asked for the next element.
+
+
+template <class T>
+class [[nodiscard]] generator : public std::ranges::view_base {
+public:
+    using value_type = std::remove_cvref_t<T>;
+    using reference = const value_type&;
+
+    struct promise_type {
+        static void* operator new(size_t size) {
+            return allocate_frame(size);
+        }
+
+        static void operator delete(void* frame, size_t size) noexcept {
+            deallocate_frame(frame, size);
+        }
+
+        generator get_return_object() noexcept {
+            return generator(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        constexpr auto initial_suspend() const noexcept {
+            return std::suspend_always{};
+        }
+
+        constexpr auto final_suspend() const noexcept {
+            return std::suspend_always{};
+        }
+
+        auto yield_value(const value_type& value) noexcept {
+            m_value = std::addressof(value);
+            return std::suspend_always{};
+        }
+
+        constexpr void return_void() const noexcept {}
+
+        void unhandled_exception() const {
+            throw;
+        }
+
+        // Only co_yield, a generator cannot wait for anything.
+        void await_transform() = delete;
+
+        const value_type* m_value = nullptr;
+    };
+
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    class iterator {
+    public:
+        using value_type = generator::value_type;
+        using reference = generator::reference;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        explicit iterator(handle_type handle) noexcept : m_handle(handle) {}
+
+        reference operator*() const noexcept {
+            return *m_handle.promise().m_value;
+        }
+
+        const value_type* operator->() const noexcept {
+            return m_handle.promise().m_value;
+        }
+
+        iterator& operator++() {
+            m_handle.resume();
+            return *this;
+        }
+
+        void operator++(int) {
+            ++*this;
+        }
+
+        friend bool operator==(const iterator& it, std::default_sentinel_t) noexcept {
+            return it.m_handle.done();
+        }
+
+    private:
+        handle_type m_handle;
+    };
+
+    explicit generator(handle_type handle) noexcept : m_handle(handle) {}
+
+    generator(generator&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    generator& operator=(generator&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~generator() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    iterator begin() {
+        start();
+        return iterator(m_handle);
+    }
+
+    std::default_sentinel_t end() const noexcept {
+        return {};
+    }
+
+    // The cursor interface. Asking whether the cursor is done needs the
+    // coroutine to run up to its first co_yield, so a const cursor starts it
+    // too.
+    friend bool cursor_done(const generator& gen) {
+        gen.start();
+        return gen.m_handle.done();
+    }
+
+    friend reference cursor_get(const generator& gen) {
+        gen.start();
+        return *gen.m_handle.promise().m_value;
+    }
+
+    friend void cursor_next(generator& gen) {
+        gen.start();
+        gen.m_handle.resume();
+    }
+
+private:
+    // A coroutine that did not yield yet and is not done did not start.
+    void start() const {
+        if (!m_handle.promise().m_value && !m_handle.done()) {
+            m_handle.resume();
+        }
+    }
+
+    handle_type m_handle;
+};
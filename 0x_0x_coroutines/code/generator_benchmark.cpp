@@ -0,0 +1,108 @@
+#include "benchmark.hpp"
+#include "cursor.hpp"
+#include "generator.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ranges>
+#include <vector>
+
+
+// The per-element cost of the same lazy sequence, the squares of the first
+// count numbers, as a hand-rolled cursor, as a std::views pipeline and as a
+// generator, on its own and combined with either kind of algorithms.
+
+
+using value_t = std::uint64_t;
+
+
+generator<value_t> numbers(value_t value) {
+    for (;;) {
+        co_yield value++;
+    }
+}
+
+
+generator<value_t> squares(value_t count) {
+    for (value_t value = 0; value < count; ++value) {
+        co_yield value * value;
+    }
+}
+
+
+// Yields objects that cannot be copied.
+generator<std::unique_ptr<value_t>> boxed(value_t count) {
+    for (value_t value = 0; value < count; ++value) {
+        auto box = std::make_unique<value_t>(value);
+        co_yield box;
+    }
+}
+
+
+static_assert(cursor::Cursor<generator<value_t>>);
+static_assert(std::ranges::input_range<generator<value_t>>);
+static_assert(std::ranges::view<generator<value_t>>);
+static_assert(std::is_same_v<std::ranges::range_reference_t<generator<value_t>>, const value_t&>);
+
+
+template <std::ranges::input_range R>
+value_t sum_range(R&& range) {
+    value_t sum = 0;
+    for (const auto& x : range) {
+        sum += x;
+    }
+    return sum;
+}
+
+
+int main() {
+    using namespace cursor_library;
+
+    constexpr size_t count = 50'000'000;
+    constexpr auto square = [](value_t x) { return x * x; };
+
+    value_t expected = 0;
+    for (value_t value = 0; value < count; ++value) {
+        expected += value * value;
+    }
+
+    measure("loop:                         ", count, expected, [&] {
+        value_t sum = 0;
+        for (value_t value = 0; value < count; ++value) {
+            sum += value * value;
+        }
+        return sum;
+    });
+
+    measure("numbers_from | squared | take: ", count, expected,
+            [&] {
+                // Its operator| takes anything, so it would clash with that of std::views.
+                using namespace cursor::pipes;
+                return sum(numbers_from<value_t>{ 0 } | squared | take(int(count)));
+            });
+
+    measure("iota | transform | take:      ", count, expected,
+            [&] { return sum_range(std::views::iota(value_t(0)) | std::views::transform(square) | std::views::take(count)); });
+
+    measure("generator, as range:          ", count, expected, [&] { return sum_range(squares(count)); });
+
+    measure("generator, as cursor:         ", count, expected, [&] { return sum(squares(count)); });
+
+    measure("generator | squared | take:   ", count, expected,
+            [&] {
+                using namespace cursor::pipes;
+                return sum(numbers(0) | squared | take(int(count)));
+            });
+
+    measure("generator | transform | take: ", count, expected,
+            [&] { return sum_range(numbers(0) | std::views::transform(square) | std::views::take(count)); });
+
+    measure("generator of unique_ptr:      ", count, count * (count - 1) / 2, [&] {
+        value_t sum = 0;
+        for (const auto& box : boxed(count)) {
+            sum += *box;
+        }
+        return sum;
+    });
+}
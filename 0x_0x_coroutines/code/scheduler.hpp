@@ -0,0 +1,282 @@
+#pragma once
+
+#include "executor.hpp"
+#include "frame_allocator.hpp"
+#include "task.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+// Runs coroutines on a fixed pool of worker threads. A coroutine moves onto
+// the pool with
+//     co_await sched.schedule();
+// and continues on whichever worker picks it up. Everything it co_awaits
+// afterwards, and whatever co_awaits it, keeps running there until the next
+// suspension.
+class scheduler {
+public:
+    explicit scheduler(size_t nthreads = std::max(1u, std::thread::hardware_concurrency()))
+        : m_executor(nthreads) {}
+
+    size_t size() const {
+        return m_executor.size();
+    }
+
+    auto schedule() noexcept {
+        struct awaitable {
+            executor* m_executor;
+
+            constexpr bool await_ready() const noexcept {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle) const {
+                m_executor->post([handle] { handle.resume(); });
+            }
+
+            constexpr void await_resume() const noexcept {}
+        };
+        return awaitable{ &m_executor };
+    }
+
+private:
+    executor m_executor;
+};
+
+
+namespace scheduler_detail {
+
+// A coroutine that is started by hand and destroys itself when it is done.
+struct detached_task {
+    struct promise_type {
+        static void* operator new(size_t size) {
+            return allocate_frame(size);
+        }
+
+        static void operator delete(void* frame, size_t size) noexcept {
+            deallocate_frame(frame, size);
+        }
+
+        detached_task get_return_object() noexcept {
+            return { std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+
+        constexpr auto initial_suspend() const noexcept {
+            return std::suspend_always{};
+        }
+
+        constexpr auto final_suspend() const noexcept {
+            return std::suspend_never{};
+        }
+
+        constexpr void return_void() const noexcept {}
+
+        void unhandled_exception() const noexcept {
+            std::terminate();
+        }
+    };
+
+    void start() const {
+        m_handle.resume();
+    }
+
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+
+// Calls on_ready() when the task is done, and resumes the coroutine it
+// returns. A plain resume() instead of symmetric transfer, since a
+// coroutine that destroys itself when it is done cannot also return the next
+// one from final_suspend. That takes one extra stack frame per combinator,
+// not per task.
+template <class T, class Waiter>
+detached_task notify_when_ready(task<T>& t, Waiter* waiter) {
+    co_await t.when_ready();
+    waiter->on_ready().resume();
+}
+
+
+// Starts all tasks, and resumes the awaiting coroutine when the last one is
+// done. The count starts one higher than the number of tasks, so that tasks
+// that finish while await_suspend is still starting the others cannot
+// resume the awaiting coroutine before await_suspend is done with it.
+template <class T>
+struct all_ready {
+    explicit all_ready(std::vector<task<T>>& tasks) : m_tasks(tasks) {}
+
+    std::vector<task<T>>& m_tasks;
+    std::atomic<size_t> m_pending = 0;
+    std::coroutine_handle<> m_awaiting;
+
+    bool await_ready() const noexcept {
+        return m_tasks.empty();
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+        m_awaiting = awaiting;
+        m_pending.store(m_tasks.size() + 1, std::memory_order_relaxed);
+        for (auto& t : m_tasks) {
+            notify_when_ready(t, this).start();
+        }
+        return m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    constexpr void await_resume() const noexcept {}
+
+    std::coroutine_handle<> on_ready() noexcept {
+        if (m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            return m_awaiting;
+        }
+        return std::noop_coroutine();
+    }
+};
+
+
+// The tasks of when_any, shared between the coroutine that awaits them and
+// the tasks that are still running after the first one is done.
+template <class T>
+struct any_state {
+    explicit any_state(std::vector<task<T>> tasks) : m_tasks(std::move(tasks)) {}
+
+    std::vector<task<T>> m_tasks;
+    std::atomic<bool> m_has_winner = false;
+    size_t m_winner = 0;
+    // The awaiting coroutine is resumed by the second of: the first task to
+    // finish, and await_suspend having started all tasks.
+    std::atomic<int> m_pending = 2;
+    std::coroutine_handle<> m_awaiting;
+};
+
+
+template <class T>
+detached_task notify_first_ready(std::shared_ptr<any_state<T>> state, size_t idx) {
+    co_await state->m_tasks[idx].when_ready();
+    std::coroutine_handle<> next = std::noop_coroutine();
+    if (!state->m_has_winner.exchange(true, std::memory_order_relaxed)) {
+        state->m_winner = idx;
+        if (state->m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            next = state->m_awaiting;
+        }
+    }
+    next.resume();
+    // The frame still holds the state, so the losers stay alive until they
+    // are done, even after when_any has returned.
+}
+
+
+// Holds the state by reference: GCC 12 destroys the operand of co_await
+// twice when it is a temporary with a destructor, which would release the
+// state once too often.
+template <class T>
+struct first_ready {
+    const std::shared_ptr<any_state<T>>& m_state;
+
+    constexpr bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> awaiting) {
+        m_state->m_awaiting = awaiting;
+        for (size_t idx = 0; idx < m_state->m_tasks.size(); ++idx) {
+            notify_first_ready(m_state, idx).start();
+        }
+        return m_state->m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    constexpr void await_resume() const noexcept {}
+};
+
+
+// The end of sync_wait: wakes up the waiting thread.
+struct sync_wait_event {
+    void set() {
+        std::lock_guard lock(m_mutex);
+        m_done = true;
+        m_cv.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock lock(m_mutex);
+        m_cv.wait(lock, [this] { return m_done; });
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_done = false;
+};
+
+
+template <class T>
+detached_task set_when_ready(task<T>& t, sync_wait_event& event) {
+    co_await t.when_ready();
+    event.set();
+}
+
+} // namespace scheduler_detail
+
+
+// Run all tasks concurrently, as far as they move themselves onto a
+// scheduler, and finish when all of them are done. Returns their results in
+// order, or rethrows the exception of the first task that failed.
+template <class T>
+auto when_all(std::vector<task<T>> tasks) -> task<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> {
+    co_await scheduler_detail::all_ready<T>(tasks);
+    if constexpr (std::is_void_v<T>) {
+        for (auto& t : tasks) {
+            t.handle().promise().get_result();
+        }
+    }
+    else {
+        std::vector<T> results;
+        results.reserve(tasks.size());
+        for (auto& t : tasks) {
+            results.push_back(t.handle().promise().get_result());
+        }
+        co_return results;
+    }
+}
+
+
+// Run all tasks concurrently, and finish as soon as the first one is done,
+// with its index and result, or its exception. The other tasks cannot be
+// cancelled: they keep running, and are destroyed when they are done.
+template <class T>
+auto when_any(std::vector<task<T>> tasks) -> task<std::conditional_t<std::is_void_v<T>, size_t, std::pair<size_t, T>>> {
+    if (tasks.empty()) {
+        throw std::invalid_argument("when_any needs at least one task");
+    }
+    auto state = std::make_shared<scheduler_detail::any_state<T>>(std::move(tasks));
+    co_await scheduler_detail::first_ready<T>{ state };
+    auto& winner = state->m_tasks[state->m_winner];
+    if constexpr (std::is_void_v<T>) {
+        winner.handle().promise().get_result();
+        co_return state->m_winner;
+    }
+    else {
+        co_return std::pair<size_t, T>{ state->m_winner, winner.handle().promise().get_result() };
+    }
+}
+
+
+// Run the task and block the calling thread until it is done, on whatever
+// thread it finishes. For the top level of a program, where task::get()
+// would return as soon as the task moves to a scheduler.
+template <class T>
+T sync_wait(task<T> t) {
+    scheduler_detail::sync_wait_event event;
+    scheduler_detail::set_when_ready(t, event).start();
+    event.wait();
+    return t.handle().promise().get_result();
+}
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "frame_allocator.hpp"
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+
+// A lazily started coroutine task, as in task.cpp, but asynchronous:
+// co_await-ing a task suspends the awaiting coroutine, stores it in the
+// task's promise as its continuation, and transfers control to the task.
+// When the task finishes, its final_suspend transfers control back to the
+// continuation. Both transfers return a coroutine_handle from await_suspend
+// (symmetric transfer) instead of calling resume(), so the compiler can
+// jump from one coroutine to the next, and a chain of a million nested
+// co_awaits runs in constant native stack space. GCC only does so with
+// -foptimize-sibling-calls, which is part of -O2, and which CMakeLists.txt
+// adds for builds with less optimization. Otherwise every co_await of a task
+// takes some stack, including a loop of co_awaits of tasks that complete
+// right away.
+//
+// An exception escaping the coroutine is stored and rethrown from co_await
+// or get().
+
+
+template <class T>
+class task;
+
+
+namespace task_detail {
+
+struct promise_base {
+    struct final_awaiter {
+        constexpr bool await_ready() const noexcept {
+            return false;
+        }
+
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) const noexcept {
+            return handle.promise().m_continuation;
+        }
+
+        constexpr void await_resume() const noexcept {}
+    };
+
+    // Frames come from the pool of the calling thread, or from the memory
+    // resource of a polymorphic_allocator passed right after
+    // std::allocator_arg as the first arguments of the coroutine:
+    //     task<int> compute(std::allocator_arg_t, std::pmr::polymorphic_allocator<> alloc, int x);
+    // GCC warns about such coroutines with -Wmismatched-new-delete, see
+    // frame_allocation.cpp.
+    static void* operator new(size_t size) {
+        return allocate_frame(size);
+    }
+
+    template <class... Args>
+    static void* operator new(size_t size, std::allocator_arg_t, std::pmr::polymorphic_allocator<> alloc, Args&...) {
+        return allocate_frame(size, alloc.resource());
+    }
+
+    static void operator delete(void* frame, size_t size) noexcept {
+        deallocate_frame(frame, size);
+    }
+
+    constexpr auto initial_suspend() const noexcept {
+        return std::suspend_always{};
+    }
+
+    constexpr auto final_suspend() const noexcept {
+        return final_awaiter{};
+    }
+
+    void unhandled_exception() noexcept {
+        m_exception = std::current_exception();
+    }
+
+    void rethrow_if_exception() const {
+        if (m_exception) {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+    // Resumed when the task finishes. Nothing for a task that was started
+    // with get().
+    std::coroutine_handle<> m_continuation = std::noop_coroutine();
+    std::exception_ptr m_exception;
+};
+
+
+template <class T>
+struct promise : promise_base {
+    task<T> get_return_object() noexcept;
+
+    template <class U>
+    void return_value(U&& value) {
+        m_result.emplace(std::forward<U>(value));
+    }
+
+    T get_result() {
+        rethrow_if_exception();
+        return std::move(m_result.value());
+    }
+
+private:
+    std::optional<T> m_result;
+};
+
+
+template <>
+struct promise<void> : promise_base {
+    task<void> get_return_object() noexcept;
+
+    constexpr void return_void() const noexcept {}
+
+    void get_result() const {
+        rethrow_if_exception();
+    }
+};
+
+} // namespace task_detail
+
+
+template <class T>
+class [[nodiscard]] task {
+public:
+    using promise_type = task_detail::promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit task(handle_type handle) noexcept : m_handle(handle) {}
+
+    task(task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+    task& operator=(task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, nullptr);
+        }
+        return *this;
+    }
+
+    ~task() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    // Run the task on this thread and return its result. Only for tasks that
+    // do not suspend on anything but other tasks, since get() returns as soon
+    // as the task suspends.
+    T get() {
+        m_handle.resume();
+        if (!m_handle.done()) {
+            throw std::logic_error("task suspended outside of get()");
+        }
+        return m_handle.promise().get_result();
+    }
+
+    auto operator co_await() const noexcept {
+        struct awaitable {
+            handle_type m_handle;
+
+            bool await_ready() const noexcept {
+                return m_handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+                m_handle.promise().m_continuation = awaiting;
+                return m_handle;
+            }
+
+            T await_resume() const {
+                return m_handle.promise().get_result();
+            }
+        };
+        return awaitable{ m_handle };
+    }
+
+    // Like co_await on the task, but without taking its result, which stays
+    // in the promise. For combinators like when_all.
+    auto when_ready() const noexcept {
+        struct awaitable {
+            handle_type m_handle;
+
+            bool await_ready() const noexcept {
+                return m_handle.done();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) const noexcept {
+                m_handle.promise().m_continuation = awaiting;
+                return m_handle;
+            }
+
+            constexpr void await_resume() const noexcept {}
+        };
+        return awaitable{ m_handle };
+    }
+
+    handle_type handle() const noexcept {
+        return m_handle;
+    }
+
+private:
+    handle_type m_handle;
+};
+
+
+namespace task_detail {
+
+template <class T>
+task<T> promise<T>::get_return_object() noexcept {
+    return task<T>(std::coroutine_handle<promise>::from_promise(*this));
+}
+
+inline task<void> promise<void>::get_return_object() noexcept {
+    return task<void>(std::coroutine_handle<promise>::from_promise(*this));
+}
+
+} // namespace task_detail
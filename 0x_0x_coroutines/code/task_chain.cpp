@@ -0,0 +1,95 @@
+#include "task.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#ifdef _MSC_VER
+    #define NOINLINE __declspec(noinline)
+#else
+    #define NOINLINE __attribute__((noinline))
+#endif
+
+
+// Address of a local in main, to tell how much native stack the innermost
+// coroutine of a chain is running on.
+std::uintptr_t stack_base = 0;
+size_t max_stack_use = 0;
+
+
+NOINLINE void record_stack_use() {
+    volatile char local = 0;
+    const auto address = reinterpret_cast<std::uintptr_t>(&local);
+    if (stack_base > address) {
+        max_stack_use = std::max<size_t>(max_stack_use, stack_base - address);
+    }
+}
+
+
+// Each level awaits the next one, the innermost returns 0 or throws.
+task<size_t> chain(size_t depth, bool fail) {
+    if (depth == 0) {
+        record_stack_use();
+        if (fail) {
+            throw std::runtime_error("innermost task failed");
+        }
+        co_return 0;
+    }
+    co_return co_await chain(depth - 1, fail) + 1;
+}
+
+
+task<void> void_chain(size_t depth, size_t& count) {
+    if (depth == 0) {
+        record_stack_use();
+        co_return;
+    }
+    co_await void_chain(depth - 1, count);
+    ++count;
+}
+
+
+template <class Fun>
+void measure(const std::string& name, size_t depth, Fun&& fun) {
+    max_stack_use = 0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    fun();
+    const auto end = std::chrono::high_resolution_clock::now();
+    std::cout << name << depth << " deep: "
+              << std::chrono::duration<double, std::nano>(end - start).count() / depth << " ns per await, "
+              << max_stack_use << " bytes of stack" << std::endl;
+}
+
+
+int main() {
+    volatile char base = 0;
+    stack_base = reinterpret_cast<std::uintptr_t>(&base);
+
+    // The stack use stays the same however deep the chain gets.
+    for (size_t depth : { 1'000, 1'000'000 }) {
+        measure("task<size_t>, ", depth, [depth] {
+            if (chain(depth, false).get() != depth) {
+                throw std::logic_error("incorrect result");
+            }
+        });
+        measure("task<void>, ", depth, [depth] {
+            size_t count = 0;
+            void_chain(depth, count).get();
+            if (count != depth) {
+                throw std::logic_error("incorrect result");
+            }
+        });
+        measure("exception through ", depth, [depth] {
+            try {
+                chain(depth, true).get();
+                throw std::logic_error("exception was lost");
+            }
+            catch (const std::runtime_error&) {
+            }
+        });
+    }
+}
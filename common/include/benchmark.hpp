@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cursor.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+// What the cursor benchmarks share: timing a run per element, checking its
+// result, and a plain loop over a cursor to consume a pipeline with.
+
+// Wall time of fun() in nanoseconds, divided by count.
+template <class Fun>
+double ns_per_element(std::size_t count, Fun&& fun) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    fun();
+    const auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / count;
+}
+
+// Prints the time per element of fun(), after checking that it returns expected.
+template <class T, class Fun>
+void measure(const std::string& name, std::size_t count, T expected, Fun&& fun) {
+    T result{};
+    const double ns = ns_per_element(count, [&] { result = fun(); });
+    if (result != expected) {
+        throw std::logic_error("incorrect result");
+    }
+    std::cout << name << ns << " ns/element" << std::endl;
+}
+
+template <cursor::Cursor C>
+cursor::value_t<C> sum(C cur) {
+    cursor::value_t<C> result = 0;
+    for (; !cursor::done(cur); cursor::next(cur)) {
+        result += cursor::get(cur);
+    }
+    return result;
+}
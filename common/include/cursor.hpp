@@ -0,0 +1,494 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#if __cpp_deduction_guides < 201907L
+    #define CURSOR_NO_CTAD_AGGREGATES
+#endif
+
+// Define CURSOR_NO_FUSION to nest adjacent transforms and filters instead of
+// fusing them into one cursor, to compare.
+
+// concept
+namespace cursor {
+// default done
+auto inline cursor_done(...) { return false; }
+
+// cursor fallback
+auto cursor_done(auto const& cur) -> decltype(cur.done()) { return cur.done(); }
+auto cursor_next(auto& cur) -> decltype(cur.next()) { cur.next(); }
+auto cursor_get(auto const& cur) -> decltype(cur.get()) { return cur.get(); }
+
+constexpr inline auto done = [](auto const& cur) -> decltype(cursor_done(cur)) {
+    return cursor_done(cur);
+};
+constexpr inline auto next = [](auto& cur) -> decltype(cursor_next(cur)) {
+    cursor_next(cur);
+};
+constexpr inline auto get = [](auto const& cur) -> decltype(cursor_get(cur)) {
+    return cursor_get(cur);
+};
+
+template <class T>
+concept Cursor =
+    std::move_constructible<T> && requires(T& cur, T const& const_cur) {
+    {
+        done(const_cur)
+        } -> std::convertible_to<bool>;
+    get(const_cur);
+    next(cur);
+};
+
+template <Cursor C>
+using value_t = std::remove_cvref_t<decltype(get(std::declval<C const&>()))>;
+
+// batch extension
+// A cursor can also hand out many elements at once with
+//     std::size_t cursor_get_batch(C& cur, std::span<T> out);
+// which copies up to out.size() elements to out, moves past them, and
+// returns how many, fewer than out.size() only when the cursor is done. A
+// loop that fills a contiguous buffer can be vectorized, one element per
+// next() cannot. get_batch falls back to single steps for cursors without it.
+constexpr inline auto get_batch = []<class T>(auto& cur, std::span<T> out) -> std::size_t {
+    if constexpr (requires { cursor_get_batch(cur, out); }) {
+        return cursor_get_batch(cur, out);
+    }
+    else {
+        std::size_t n = 0;
+        for (; n < out.size() && !done(cur); next(cur)) {
+            out[n++] = get(cur);
+        }
+        return n;
+    }
+};
+
+// Size of the buffers of adaptors that cannot work in place in out.
+constexpr inline std::size_t batch_size = 256;
+
+// jump extension
+// A cursor can move past n elements at once with
+//     void cursor_advance(C& cur, std::size_t n);
+// There is no fallback, a cursor has it only if it is cheap.
+constexpr inline auto advance = [](auto& cur, std::size_t n) -> decltype(cursor_advance(cur, n)) {
+    cursor_advance(cur, n);
+};
+
+// split extension
+// A copyable cursor that knows how many elements it has left,
+//     std::size_t cursor_size(C const& cur);
+// and can hand off the second half of them,
+//     C cursor_split(C& cur);
+// which returns a cursor of the second half and keeps the first half, can be
+// traversed by several threads at once. The size can be an upper bound, as
+// after a filter, but is 0 only if the cursor is done.
+constexpr inline auto size = [](auto const& cur) -> decltype(cursor_size(cur)) {
+    return cursor_size(cur);
+};
+constexpr inline auto split = [](auto& cur) -> decltype(cursor_split(cur)) {
+    return cursor_split(cur);
+};
+
+template <class T>
+concept SplittableCursor =
+    Cursor<T> && std::is_object_v<T> && std::copy_constructible<T> && requires(T& cur, T const& const_cur) {
+    {
+        size(const_cur)
+        } -> std::convertible_to<std::size_t>;
+    {
+        split(cur)
+        } -> std::same_as<T>;
+};
+
+namespace pipes {
+    template <class F, class G>
+    constexpr auto operator|(F&& f, G&& g) -> decltype(auto) {
+        if constexpr (std::is_invocable_v<G&&, F&&>) {
+            return std::forward<G>(g)(std::forward<F>(f));
+        }
+        else {
+            return [g = std::forward<G>(g), f = std::forward<F>(f)](auto&&... args) {
+                return g(f(std::forward<decltype(args)...>(args...)));
+            };
+        }
+    }
+}; // namespace pipes
+
+// Type erased cursor of elements convertible to T. Cursors of up to
+// InlineSize bytes are stored in place, larger ones on the heap. Instead of
+// virtual functions, a static table of function pointers per cursor type
+// does the dispatch, and get_batch and next_n amortize it over many elements:
+// the loop over the elements runs inside the erased type, where done, get
+// and next are inlined.
+template <class T, std::size_t InlineSize = 4 * sizeof(void*)>
+class any_cursor {
+    template <class C>
+    static constexpr bool fits_inline_ = sizeof(C) <= InlineSize && alignof(C) <= alignof(std::max_align_t)
+                                         && std::is_nothrow_move_constructible_v<C>;
+
+    struct vtable {
+        bool (*done)(void const* storage);
+        T (*get)(void const* storage);
+        void (*next)(void* storage);
+        std::size_t (*get_batch)(void* storage, std::span<T> out);
+        std::size_t (*next_n)(void* storage, std::size_t n);
+        // Moves the cursor from src to dst and destroys it in src.
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    // The cursor in storage, or the cursor that storage points to.
+    template <class C, bool Inline>
+    static C& stored_(void* storage) {
+        if constexpr (Inline) {
+            return *static_cast<C*>(storage);
+        }
+        else {
+            return **static_cast<C**>(storage);
+        }
+    }
+
+    template <class C, bool Inline>
+    static C const& stored_(void const* storage) {
+        return stored_<C, Inline>(const_cast<void*>(storage));
+    }
+
+    // Moves a cursor out of its slot, and back in when it goes out of scope.
+    template <Cursor C>
+    struct local_cursor_ {
+        C& slot_;
+        C cur_;
+
+        explicit local_cursor_(C& slot) : slot_(slot), cur_(std::move(slot)) { slot.~C(); }
+        ~local_cursor_() { ::new (static_cast<void*>(&slot_)) C(std::move(cur_)); }
+    };
+
+    template <Cursor C, bool Inline>
+    static constexpr vtable vtable_for_{
+        [](void const* storage) -> bool { return cursor::done(stored_<C, Inline>(storage)); },
+        [](void const* storage) -> T { return cursor::get(stored_<C, Inline>(storage)); },
+        [](void* storage) { cursor::next(stored_<C, Inline>(storage)); },
+        [](void* storage, std::span<T> out) -> std::size_t {
+            C& stored = stored_<C, Inline>(storage);
+            if constexpr (std::is_nothrow_move_constructible_v<C>) {
+                // Runs the loop on a local copy, which the compiler can keep
+                // in registers, since out cannot point into it.
+                local_cursor_<C> local(stored);
+                return cursor::get_batch(local.cur_, out);
+            }
+            else {
+                return cursor::get_batch(stored, out);
+            }
+        },
+        [](void* storage, std::size_t n) -> std::size_t {
+            C& cur = stored_<C, Inline>(storage);
+            std::size_t skipped = 0;
+            for (; skipped < n && !cursor::done(cur); cursor::next(cur)) {
+                ++skipped;
+            }
+            return skipped;
+        },
+        [](void* dst, void* src) noexcept {
+            if constexpr (Inline) {
+                ::new (dst) C(std::move(stored_<C, true>(src)));
+                stored_<C, true>(src).~C();
+            }
+            else {
+                ::new (dst) C*(*static_cast<C**>(src));
+            }
+        },
+        [](void* storage) noexcept {
+            if constexpr (Inline) {
+                stored_<C, true>(storage).~C();
+            }
+            else {
+                delete &stored_<C, false>(storage);
+            }
+        },
+    };
+
+    // At least the pointer to a cursor on the heap, even for an InlineSize of 0.
+    alignas(std::max_align_t) std::byte storage_[std::max(InlineSize, sizeof(void*))];
+    vtable const* vtable_ = nullptr;
+
+public:
+    // Not the copy or move constructor: checking Cursor<any_cursor> for those
+    // would depend on itself.
+    template <class C>
+        requires(!std::same_as<std::decay_t<C>, any_cursor> && Cursor<C>)
+    any_cursor(C cur) {
+        if constexpr (fits_inline_<C>) {
+            ::new (static_cast<void*>(storage_)) C(std::move(cur));
+            vtable_ = &vtable_for_<C, true>;
+        }
+        else {
+            ::new (static_cast<void*>(storage_)) C*(new C(std::move(cur)));
+            vtable_ = &vtable_for_<C, false>;
+        }
+    }
+
+    // A moved-from any_cursor can only be assigned to or destroyed.
+    any_cursor(any_cursor&& other) noexcept : vtable_(std::exchange(other.vtable_, nullptr)) {
+        if (vtable_) {
+            vtable_->move(storage_, other.storage_);
+        }
+    }
+
+    any_cursor& operator=(any_cursor&& other) noexcept {
+        if (this != &other) {
+            reset_();
+            vtable_ = std::exchange(other.vtable_, nullptr);
+            if (vtable_) {
+                vtable_->move(storage_, other.storage_);
+            }
+        }
+        return *this;
+    }
+
+    ~any_cursor() { reset_(); }
+
+    // Copies up to out.size() elements to out and moves past them. Returns
+    // how many, which is less than out.size() only when the cursor is done.
+    std::size_t get_batch(std::span<T> out) { return vtable_->get_batch(storage_, out); }
+
+    // Moves past up to n elements, and returns how many.
+    std::size_t next_n(std::size_t n) { return vtable_->next_n(storage_, n); }
+
+    friend std::size_t cursor_get_batch(any_cursor& cur, std::span<T> out) { return cur.get_batch(out); }
+    friend bool cursor_done(any_cursor const& cur) { return cur.vtable_->done(cur.storage_); }
+    friend void cursor_next(any_cursor& cur) { cur.vtable_->next(cur.storage_); }
+    friend T cursor_get(any_cursor const& cur) { return cur.vtable_->get(cur.storage_); }
+
+private:
+    void reset_() {
+        if (vtable_) {
+            std::exchange(vtable_, nullptr)->destroy(storage_);
+        }
+    }
+};
+
+namespace impl_ {
+    struct sentinel {};
+
+    template <Cursor C>
+    struct iter {
+        C& cur_;
+
+        decltype(auto) operator*() const {
+            return cursor::get(cur_);
+        }
+        void operator++() {
+            cursor::next(cur_);
+        }
+        bool operator!=(sentinel) const {
+            return !cursor::done(cur_);
+        }
+    };
+} // namespace impl_
+
+template <Cursor C>
+impl_::iter<C> begin(C& cur) { return { cur }; }
+template <Cursor C>
+impl_::sentinel end(C const& cur) { return {}; }
+
+} // namespace cursor
+
+// cursor and cursor algorithm implementations
+namespace cursor_library {
+using cursor::Cursor;
+
+template <std::integral T>
+struct numbers_from {
+    T value_;
+
+#ifdef CURSOR_NO_CTAD_AGGREGATES
+    numbers_from(T value) : value_(value) {}
+#endif
+
+    friend T const& cursor_get(numbers_from const& cur) { return cur.value_; }
+    friend void cursor_next(numbers_from& cur) { ++cur.value_; }
+    friend std::size_t cursor_get_batch(numbers_from& cur, std::span<T> out) {
+        // A local copy, which out cannot alias, so that the loop vectorizes.
+        const T value = cur.value_;
+        for (std::size_t idx = 0; idx < out.size(); ++idx) {
+            out[idx] = value + T(idx);
+        }
+        cur.value_ = value + T(out.size());
+        return out.size();
+    }
+    friend void cursor_advance(numbers_from& cur, std::size_t n) { cur.value_ += T(n); }
+};
+static_assert(Cursor<numbers_from<int>>);
+
+template <Cursor C>
+struct take_impl_ {
+    C cur_;
+    int left_;
+
+#ifdef CURSOR_NO_CTAD_AGGREGATES
+    template <Cursor T>
+    take_impl_(T&& cur, int left) : cur_{ std::forward<T>(cur) }, left_{ left } {}
+#endif
+
+    friend auto cursor_get(take_impl_ const& cur) -> decltype(auto) {
+        return cursor::get(cur.cur_);
+    }
+    friend void cursor_next(take_impl_& cur) {
+        --cur.left_;
+        cursor::next(cur.cur_);
+    }
+    friend auto cursor_done(take_impl_ const& cur) -> decltype(auto) {
+        return cursor::done(cur.cur_) || cur.left_ <= 0;
+    }
+    template <class T>
+    friend std::size_t cursor_get_batch(take_impl_& cur, std::span<T> out) {
+        const auto left = std::size_t(std::max(cur.left_, 0));
+        const std::size_t n = cursor::get_batch(cur.cur_, out.first(std::min(out.size(), left)));
+        cur.left_ -= int(n);
+        return n;
+    }
+    friend void cursor_advance(take_impl_& cur, std::size_t n)
+        requires requires(C& inner) { cursor::advance(inner, n); }
+    {
+        n = std::min(n, std::size_t(std::max(cur.left_, 0)));
+        cursor::advance(cur.cur_, n);
+        cur.left_ -= int(n);
+    }
+    // Splittable if the underlying cursor can jump, like numbers_from.
+    friend std::size_t cursor_size(take_impl_ const& cur)
+        requires requires(C& inner) { cursor::advance(inner, 0); }
+    {
+        const auto left = std::size_t(std::max(cur.left_, 0));
+        if constexpr (requires { cursor::size(cur.cur_); }) {
+            return std::min(left, std::size_t(cursor::size(cur.cur_)));
+        }
+        else {
+            return cursor::done(cur.cur_) ? 0 : left;
+        }
+    }
+    friend take_impl_ cursor_split(take_impl_& cur)
+        requires std::is_object_v<C> && std::copy_constructible<C>
+                 && requires(C& inner) { cursor::advance(inner, 0); }
+    {
+        const int half = std::max(cur.left_, 0) / 2;
+        take_impl_ back = cur;
+        cursor::advance(back.cur_, std::size_t(half));
+        back.left_ -= half;
+        cur.left_ = half;
+        return back;
+    }
+};
+
+constexpr inline auto take = [](int n) {
+    return [n]<Cursor C>(C&& cur) { return take_impl_<C>(std::forward<C>(cur), n); };
+};
+
+template <class Fun, Cursor C>
+struct transform_impl_ {
+    Fun fun_;
+    C cur_;
+
+#ifdef CURSOR_NO_CTAD_AGGREGATES
+    template <Cursor T>
+    transform_impl_(Fun fun, T&& cur) : fun_{ std::move(fun) }, cur_{ std::forward<T>(cur) } {}
+#endif
+
+    friend auto cursor_get(transform_impl_ const& transf_) -> decltype(auto) {
+        return transf_.fun_(cursor::get(transf_.cur_));
+    }
+    friend void cursor_next(transform_impl_& transf_) {
+        cursor::next(transf_.cur_);
+    }
+    friend auto cursor_done(transform_impl_ const& transf_) -> decltype(auto) {
+        return cursor::done(transf_.cur_);
+    }
+    // Gets a batch from the underlying cursor, in place if it has the same
+    // element type, then transforms it.
+    template <class T>
+    friend std::size_t cursor_get_batch(transform_impl_& transf_, std::span<T> out) {
+        using U = cursor::value_t<C>;
+        if constexpr (std::is_same_v<U, T>) {
+            const std::size_t n = cursor::get_batch(transf_.cur_, out);
+            for (std::size_t idx = 0; idx < n; ++idx) {
+                out[idx] = transf_.fun_(out[idx]);
+            }
+            return n;
+        }
+        else {
+            U buffer[cursor::batch_size];
+            std::size_t n = 0;
+            while (n < out.size()) {
+                const std::size_t wanted = std::min(out.size() - n, cursor::batch_size);
+                const std::size_t got = cursor::get_batch(transf_.cur_, std::span<U>(buffer, wanted));
+                for (std::size_t idx = 0; idx < got; ++idx) {
+                    out[n + idx] = transf_.fun_(buffer[idx]);
+                }
+                n += got;
+                if (got < wanted) {
+                    break;
+                }
+            }
+            return n;
+        }
+    }
+    friend void cursor_advance(transform_impl_& transf_, std::size_t n)
+        requires requires(C& inner) { cursor::advance(inner, n); }
+    {
+        cursor::advance(transf_.cur_, n);
+    }
+    friend std::size_t cursor_size(transform_impl_ const& transf_)
+        requires cursor::SplittableCursor<C>
+    {
+        return cursor::size(transf_.cur_);
+    }
+    friend transform_impl_ cursor_split(transform_impl_& transf_)
+        requires cursor::SplittableCursor<C> && std::copy_constructible<Fun>
+    {
+        return transform_impl_{ transf_.fun_, cursor::split(transf_.cur_) };
+    }
+};
+
+// A transform of a transform is one transform of the composed functions,
+// instead of two nested cursors. Only a temporary cursor is fused, a named one
+// has to advance as it is used.
+template <class Fun, Cursor C, class G>
+auto fuse_transform_(transform_impl_<Fun, C>&& inner, G g) {
+    auto fused = [f = std::move(inner.fun_), g = std::move(g)](auto&& value) -> decltype(auto) {
+        return g(f(std::forward<decltype(value)>(value)));
+    };
+    return transform_impl_<decltype(fused), C>(std::move(fused), std::forward<C>(inner.cur_));
+}
+
+constexpr inline auto transform = [](auto f) {
+    return [f = std::move(f)]<Cursor C>(C&& cur) {
+#ifndef CURSOR_NO_FUSION
+        if constexpr (requires { fuse_transform_(std::forward<C>(cur), f); }) {
+            return fuse_transform_(std::forward<C>(cur), f);
+        }
+        else
+#endif
+        {
+            return transform_impl_<decltype(f), C>(std::move(f), std::forward<C>(cur));
+        }
+    };
+};
+
+constexpr inline auto squared = transform([](auto a) { return a * a; });
+
+constexpr inline auto dump = [](Cursor auto cur) {
+    for (auto v : cur) {
+        std::cout << v << ", ";
+    }
+    std::cout << std::endl;
+};
+
+using cursor::begin;
+using cursor::end;
+} // namespace cursor_library
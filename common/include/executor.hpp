@@ -0,0 +1,169 @@
+#pragma once
+
+#include "unique_function.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// A task in the queue of an executor. A task from make_task with a function
+// pointer and a few arguments is stored inline, even together with the
+// promise that submit adds.
+using small_task = unique_function<void()>;
+
+// First in, first out queue of tasks in a ring buffer, which only allocates
+// when it grows.
+class task_queue {
+public:
+    bool empty() const { return m_size == 0; }
+    size_t size() const { return m_size; }
+
+    void push(small_task&& task) {
+        if (m_size == m_slots.size()) {
+            grow();
+        }
+        m_slots[(m_head + m_size) & (m_slots.size() - 1)] = std::move(task);
+        ++m_size;
+    }
+
+    // Requires !empty().
+    small_task pop() {
+        small_task task = std::move(m_slots[m_head]);
+        m_head = (m_head + 1) & (m_slots.size() - 1);
+        --m_size;
+        return task;
+    }
+
+private:
+    void grow() {
+        std::vector<small_task> slots(std::max<size_t>(16, 2 * m_slots.size()));
+        for (size_t idx = 0; idx < m_size; ++idx) {
+            slots[idx] = std::move(m_slots[(m_head + idx) & (m_slots.size() - 1)]);
+        }
+        m_slots = std::move(slots);
+        m_head = 0;
+    }
+
+    std::vector<small_task> m_slots; // The size is a power of two.
+    size_t m_head = 0;
+    size_t m_size = 0;
+};
+
+// Runs tasks on a fixed set of worker threads, in the order they were
+// submitted. Tasks can submit further tasks. The destructor runs the tasks
+// that are still queued before it joins the workers.
+class executor {
+public:
+    explicit executor(size_t nthreads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t idx = 0; idx < nthreads; ++idx) {
+            m_workers.emplace_back([this] { work(); });
+        }
+    }
+
+    executor(const executor&) = delete;
+    executor& operator=(const executor&) = delete;
+
+    ~executor() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_ready.notify_all();
+        std::ranges::for_each(m_workers, [](auto& th) { th.join(); });
+    }
+
+    size_t size() const { return m_workers.size(); }
+
+    // Run f without a way to get its result. Like with std::thread, an
+    // exception escaping f calls std::terminate. Never allocates for
+    // callables that fit into a small_task, except when the queue grows.
+    template <class F>
+    void post(F&& f) {
+        push(small_task(std::forward<F>(f)));
+    }
+
+    // Run f, and return a future for its result or exception. The future's
+    // shared state is allocated, the task itself is stored like with post.
+    template <class F>
+    auto submit(F&& f) {
+        using R = std::invoke_result_t<std::decay_t<F>&>;
+
+        struct with_promise {
+            std::decay_t<F> f;
+            std::promise<R> promise;
+
+            void operator()() {
+                try {
+                    if constexpr (std::is_void_v<R>) {
+                        f();
+                        promise.set_value();
+                    }
+                    else {
+                        promise.set_value(f());
+                    }
+                }
+                catch (...) {
+                    promise.set_exception(std::current_exception());
+                }
+            }
+        };
+
+        std::promise<R> promise;
+        auto future = promise.get_future();
+        post(with_promise{ std::forward<F>(f), std::move(promise) });
+        return future;
+    }
+
+    // Wait until all tasks submitted so far, and the tasks they submitted,
+    // have finished. Must not be called from a task.
+    void wait() {
+        std::unique_lock lock(m_mutex);
+        m_idle.wait(lock, [this] { return m_queue.empty() && m_running == 0; });
+    }
+
+private:
+    void push(small_task&& task) {
+        {
+            std::lock_guard lock(m_mutex);
+            m_queue.push(std::move(task));
+        }
+        m_ready.notify_one();
+    }
+
+    void work() {
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            m_ready.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            auto task = m_queue.pop();
+            ++m_running;
+
+            lock.unlock();
+            task();
+            // Destroy the callable before the task counts as finished.
+            task = {};
+            lock.lock();
+
+            if (--m_running == 0 && m_queue.empty()) {
+                m_idle.notify_all();
+            }
+        }
+    }
+
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::condition_variable m_idle;
+    task_queue m_queue;
+    size_t m_running = 0;
+    bool m_stop = false;
+    std::vector<std::thread> m_workers;
+};
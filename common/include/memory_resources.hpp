@@ -0,0 +1,227 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+
+// Memory resources for std::pmr containers, for code that allocates over
+// and over in a hot loop:
+//
+//   frame_arena frame;
+//   for (...) {
+//       std::pmr::vector<float> scratch(n, &frame);
+//       ...
+//       frame.reset();
+//   }
+
+
+// Forwards to upstream, and counts the allocations and the bytes.
+class counting_resource : public std::pmr::memory_resource {
+public:
+    explicit counting_resource(std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : m_upstream(upstream) {}
+
+    size_t allocations() const { return m_allocations.load(std::memory_order_relaxed); }
+    size_t bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        m_allocations.fetch_add(1, std::memory_order_relaxed);
+        m_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        return m_upstream->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        m_upstream->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::pmr::memory_resource* m_upstream;
+    std::atomic<size_t> m_allocations = 0;
+    std::atomic<size_t> m_bytes = 0;
+};
+
+
+// Monotonic scratch memory for one step of a loop, e.g. a time step of a
+// simulation or a frame of a game. Allocating bumps an offset, deallocating
+// does nothing, and reset() at the end of the step makes all memory
+// available again.
+//
+// Unlike std::pmr::monotonic_buffer_resource::release(), reset() keeps the
+// memory. If a step needed more than one block, the blocks are merged into
+// one, so from the second step on, steps do not allocate from upstream.
+// Not thread-safe.
+class frame_arena : public std::pmr::memory_resource {
+public:
+    explicit frame_arena(size_t initial_size = 64 * 1024,
+                         std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_upstream(upstream) {
+        add_block(initial_size);
+    }
+
+    frame_arena(const frame_arena&) = delete;
+    frame_arena& operator=(const frame_arena&) = delete;
+
+    ~frame_arena() { release_blocks(); }
+
+    // Everything allocated since the last reset must not be used anymore.
+    void reset() {
+        if (m_blocks.size() > 1) {
+            size_t total_size = 0;
+            for (const auto& block : m_blocks) {
+                total_size += block.size;
+            }
+            release_blocks();
+            add_block(total_size);
+        }
+        m_used = 0;
+    }
+
+    size_t capacity() const {
+        size_t total_size = 0;
+        for (const auto& block : m_blocks) {
+            total_size += block.size;
+        }
+        return total_size;
+    }
+
+private:
+    struct block {
+        std::byte* data;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        size_t offset = aligned_offset(m_blocks.back(), alignment);
+        if (offset + bytes > m_blocks.back().size) {
+            add_block(std::max(2 * m_blocks.back().size, bytes + alignment));
+            offset = aligned_offset(m_blocks.back(), alignment);
+        }
+        m_used = offset + bytes;
+        return m_blocks.back().data + offset;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    size_t aligned_offset(const block& block, size_t alignment) const {
+        const auto base = reinterpret_cast<uintptr_t>(block.data);
+        return ((base + m_used + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+    }
+
+    void add_block(size_t size) {
+        auto data = static_cast<std::byte*>(m_upstream->allocate(size, alignof(std::max_align_t)));
+        m_blocks.push_back({ data, size });
+        m_used = 0;
+    }
+
+    void release_blocks() {
+        for (const auto& block : m_blocks) {
+            m_upstream->deallocate(block.data, block.size, alignof(std::max_align_t));
+        }
+        m_blocks.clear();
+    }
+
+    std::pmr::memory_resource* m_upstream;
+    std::vector<block> m_blocks;
+    size_t m_used = 0;
+};
+
+
+// Free lists of blocks for the sizes 8, 16, ..., 512 bytes, refilled from
+// upstream in slabs of 64 KiB. Allocating and deallocating a small object
+// pops from and pushes to a free list, and objects of the same size end up
+// next to each other. Larger or over-aligned allocations go to upstream.
+// Like std::pmr::unsynchronized_pool_resource, but small enough to read.
+// Not thread-safe.
+class size_class_pool : public std::pmr::memory_resource {
+public:
+    explicit size_class_pool(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+        : m_upstream(upstream) {}
+
+    size_class_pool(const size_class_pool&) = delete;
+    size_class_pool& operator=(const size_class_pool&) = delete;
+
+    ~size_class_pool() { release(); }
+
+    // Returns all slabs to upstream, also those with blocks still in use.
+    void release() {
+        for (auto slab : m_slabs) {
+            m_upstream->deallocate(slab, slab_size, alignof(std::max_align_t));
+        }
+        m_slabs.clear();
+        m_free_lists.fill(nullptr);
+    }
+
+private:
+    static constexpr size_t min_block_size = 8;
+    static constexpr size_t max_block_size = 512;
+    static constexpr size_t num_size_classes = 7;
+    static constexpr size_t slab_size = 64 * 1024;
+
+    struct free_block {
+        free_block* next;
+    };
+
+    // 8 -> 0, 9..16 -> 1, ..., 257..512 -> 6.
+    static size_t size_class(size_t bytes) {
+        return std::bit_width(std::max(bytes, min_block_size) - 1) - std::bit_width(min_block_size - 1);
+    }
+
+    static bool is_pooled(size_t bytes, size_t alignment) {
+        return bytes <= max_block_size && alignment <= alignof(std::max_align_t);
+    }
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        if (!is_pooled(bytes, alignment)) {
+            return m_upstream->allocate(bytes, alignment);
+        }
+        // Blocks are aligned to their size, up to the alignment of the slab.
+        const size_t idx = size_class(std::max(bytes, alignment));
+        if (!m_free_lists[idx]) {
+            refill(idx);
+        }
+        free_block* block = m_free_lists[idx];
+        m_free_lists[idx] = block->next;
+        return block;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        if (!is_pooled(bytes, alignment)) {
+            m_upstream->deallocate(p, bytes, alignment);
+            return;
+        }
+        const size_t idx = size_class(std::max(bytes, alignment));
+        m_free_lists[idx] = new (p) free_block{ m_free_lists[idx] };
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    void refill(size_t idx) {
+        const size_t block_size = min_block_size << idx;
+        auto slab = static_cast<std::byte*>(m_upstream->allocate(slab_size, alignof(std::max_align_t)));
+        m_slabs.push_back(slab);
+        for (size_t offset = slab_size; offset >= block_size; offset -= block_size) {
+            m_free_lists[idx] = new (slab + offset - block_size) free_block{ m_free_lists[idx] };
+        }
+    }
+
+    std::pmr::memory_resource* m_upstream;
+    std::array<free_block*, num_size_classes> m_free_lists{};
+    std::vector<std::byte*> m_slabs;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// A move-only, type-erased callable, like std::function but without the
+// requirement to be copyable. Callables of up to InlineSize bytes are stored
+// in place, only larger ones are allocated on the heap. The default size
+// makes a unique_function one cache line.
+template <class Signature, size_t InlineSize = 64 - sizeof(void*)>
+class unique_function;
+
+template <class R, class... Args, size_t InlineSize>
+class unique_function<R(Args...), InlineSize> {
+public:
+    static constexpr size_t inline_size = InlineSize;
+
+    template <class T>
+    static constexpr bool fits_inline = sizeof(T) <= inline_size && alignof(T) <= alignof(std::max_align_t)
+                                        && std::is_nothrow_move_constructible_v<T>;
+
+    unique_function() = default;
+
+    template <class F>
+        requires(!std::same_as<std::decay_t<F>, unique_function> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+    unique_function(F&& f) {
+        using T = std::decay_t<F>;
+        if constexpr (fits_inline<T>) {
+            ::new (static_cast<void*>(m_storage)) T(std::forward<F>(f));
+            m_vtable = &inline_vtable<T>;
+        }
+        else {
+            ::new (static_cast<void*>(m_storage)) T*(new T(std::forward<F>(f)));
+            m_vtable = &heap_vtable<T>;
+        }
+    }
+
+    unique_function(unique_function&& other) noexcept : m_vtable(std::exchange(other.m_vtable, nullptr)) {
+        if (m_vtable) {
+            m_vtable->move(m_storage, other.m_storage);
+        }
+    }
+
+    unique_function& operator=(unique_function&& other) noexcept {
+        if (this != &other) {
+            reset();
+            m_vtable = std::exchange(other.m_vtable, nullptr);
+            if (m_vtable) {
+                m_vtable->move(m_storage, other.m_storage);
+            }
+        }
+        return *this;
+    }
+
+    ~unique_function() { reset(); }
+
+    explicit operator bool() const { return m_vtable != nullptr; }
+
+    // Requires a callable, unlike std::function, which throws
+    // std::bad_function_call.
+    R operator()(Args... args) { return m_vtable->call(m_storage, std::forward<Args>(args)...); }
+
+private:
+    struct vtable {
+        R (*call)(void* storage, Args&&... args);
+        // Moves the callable from src to dst and destroys it in src.
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <class T>
+    static constexpr vtable inline_vtable{
+        [](void* storage, Args&&... args) -> R {
+            return std::invoke(*static_cast<T*>(storage), std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) noexcept {
+            ::new (dst) T(std::move(*static_cast<T*>(src)));
+            static_cast<T*>(src)->~T();
+        },
+        [](void* storage) noexcept { static_cast<T*>(storage)->~T(); },
+    };
+
+    template <class T>
+    static constexpr vtable heap_vtable{
+        [](void* storage, Args&&... args) -> R {
+            return std::invoke(**static_cast<T**>(storage), std::forward<Args>(args)...);
+        },
+        [](void* dst, void* src) noexcept { ::new (dst) T*(*static_cast<T**>(src)); },
+        [](void* storage) noexcept { delete *static_cast<T**>(storage); },
+    };
+
+    void reset() {
+        if (m_vtable) {
+            std::exchange(m_vtable, nullptr)->destroy(m_storage);
+        }
+    }
+
+    // At least the pointer to a callable on the heap, even for an InlineSize of 0.
+    alignas(std::max_align_t) std::byte m_storage[std::max(inline_size, sizeof(void*))];
+    const vtable* m_vtable = nullptr;
+};